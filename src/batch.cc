@@ -0,0 +1,306 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "brickwork.hh"
+#include "kernels.hh"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <numeric>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define BRICKWORK_X86 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+using Word = std::uint64_t;
+
+#ifdef BRICKWORK_X86
+// The pairs of lower and upper gaps arranged in chunks of L lanes. Each lane has a lower
+// gap position and the index of an upper gap. The lanes past the last pair repeat the
+// first pair, which doesn't change the result.
+template <int L> struct PairLanes
+{
+    // Arrange the pairs for upper rows with n_upper gaps.
+    void arrange(std::vector<float> const& gaps, std::size_t n)
+    {
+        n_upper = n;
+        auto const n_pairs{gaps.size()*n_upper};
+        x.resize((n_pairs + L - 1)/L);
+        y.resize(x.size());
+        for (std::size_t p{0}; p < x.size()*L; ++p)
+        {
+            auto const pair{p < n_pairs ? p : 0};
+            x[p/L][p % L] = gaps[pair % gaps.size()];
+            y[p/L][p % L] = pair/gaps.size();
+        }
+    }
+
+    // The number of upper gaps the lanes are arranged for. 0 if they're not arranged.
+    std::size_t n_upper{0};
+    std::vector<std::array<float, L>> x;
+    std::vector<std::array<int, L>> y;
+};
+#endif
+
+// The lower row's gap positions including the offset, prepared once for all candidates.
+struct Lower
+{
+    // Prepare for a new lower row. The buffers keep their memory from earlier rows.
+    void prepare(Row const& row, PeriodTable const* table_)
+    {
+        offset = row.offset();
+        period = row.period();
+        table = table_;
+        perpends.assign(row.perpends().begin(), row.perpends().end());
+        gaps.clear();
+        for (auto x : row.perpends())
+            gaps.push_back(static_cast<float>(row.offset() + x));
+        known.assign(known.size(), false);
+#ifdef BRICKWORK_X86
+        sse_lanes.n_upper = 0;
+        avx_lanes.n_upper = 0;
+#endif
+    }
+    // @return The divisor for the gcd of the period with the upper row's period. Without a
+    // table, each is calculated once for each upper period.
+    Divisor const& divisor(int upper_period)
+    {
+        if (table)
+            return table->gcd_divisor(period, upper_period);
+        if (upper_period >= static_cast<int>(divisors.size()))
+        {
+            divisors.resize(upper_period + 1);
+            known.resize(upper_period + 1, false);
+        }
+        if (!known[upper_period])
+        {
+            divisors[upper_period] = Divisor(std::gcd(period, upper_period));
+            known[upper_period] = true;
+        }
+        return divisors[upper_period];
+    }
+
+    int offset{0};
+    int period{0};
+    std::vector<std::uint16_t> perpends;
+    // The positions including the offset for the vector kernels.
+    std::vector<float> gaps;
+    // The shared table, if any.
+    PeriodTable const* table{nullptr};
+    // The divisors by upper period, if there's no table.
+    std::vector<Divisor> divisors;
+    std::vector<bool> known;
+#ifdef BRICKWORK_X86
+    // The gap pairs for the vector kernels.
+    PairLanes<4> sse_lanes;
+    PairLanes<8> avx_lanes;
+#endif
+};
+
+// Check one candidate. See is_brickwork() for the test.
+bool fits(Lower& lower, Row const& upper)
+{
+    if (lower.period <= 0 || upper.period() <= 0)
+        return false;
+    auto const& d{lower.divisor(upper.period())};
+    auto const& xs{lower.perpends};
+    auto const& ys{upper.perpends()};
+    auto const shift{lower.offset - upper.offset()};
+    if (auto const check{gap_check(xs.size(), ys.size())})
+        return check(xs.data(), ys.begin(), shift, d);
+    return disjoint_gaps(xs.data(), xs.size(), ys.begin(), ys.size(), shift, d);
+}
+
+void scalar_many(Lower& lower, std::span<Row const> uppers, std::span<Word> out)
+{
+    for (std::size_t j{0}; j < uppers.size(); ++j)
+        if (fits(lower, uppers[j]))
+            out[j/word_bits] |= Word{1} << (j % word_bits);
+}
+
+#ifdef BRICKWORK_X86
+// The vector kernels check all pairs of gaps for one candidate at a time, L pairs per
+// instruction, and stop at the first chunk with a collision. Gap positions are far below
+// 2^24, so they and their products with the quotients are exact in floats. The quotient
+// computed with the reciprocal rounds to the true quotient when the division is exact,
+// so v - round(v/d)*d is zero iff d divides v. No integer division is needed.
+__attribute__((target("sse4.1")))
+void sse_many(Lower& lower, std::span<Row const> uppers, std::span<Word> out)
+{
+    auto& lanes{lower.sse_lanes};
+    std::array<float, 16> y;
+    for (std::size_t j{0}; j < uppers.size(); ++j)
+    {
+        auto const& upper{uppers[j]};
+        auto const n{upper.perpends().size()};
+        if (lower.period <= 0 || upper.period() <= 0 || n > y.size())
+        {
+            if (fits(lower, upper))
+                out[j/word_bits] |= Word{1} << (j % word_bits);
+            continue;
+        }
+        if (n != lanes.n_upper)
+            lanes.arrange(lower.gaps, n);
+        for (std::size_t k{0}; k < n; ++k)
+            y[k] = static_cast<float>(upper.offset() + upper.perpends()[k]);
+        auto const d{static_cast<float>(lower.divisor(upper.period()).value())};
+        auto const dv{_mm_set1_ps(d)};
+        auto const r{_mm_set1_ps(1.0f/d)};
+        auto hit{false};
+        for (std::size_t c{0}; !hit && c < lanes.x.size(); ++c)
+        {
+            auto const& index{lanes.y[c]};
+            auto const v{_mm_sub_ps(_mm_loadu_ps(lanes.x[c].data()),
+                                    _mm_setr_ps(y[index[0]], y[index[1]],
+                                                y[index[2]], y[index[3]]))};
+            auto const q{_mm_round_ps(_mm_mul_ps(v, r),
+                                      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)};
+            auto const e{_mm_sub_ps(v, _mm_mul_ps(q, dv))};
+            hit = _mm_movemask_ps(_mm_cmpeq_ps(e, _mm_setzero_ps())) != 0;
+        }
+        if (!hit)
+            out[j/word_bits] |= Word{1} << (j % word_bits);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+void avx2_many(Lower& lower, std::span<Row const> uppers, std::span<Word> out)
+{
+    auto& lanes{lower.avx_lanes};
+    for (std::size_t j{0}; j < uppers.size(); ++j)
+    {
+        auto const& upper{uppers[j]};
+        auto const n{upper.perpends().size()};
+        // An upper row's gaps must fit in one register to be permuted into the lanes.
+        if (lower.period <= 0 || upper.period() <= 0 || n > 8)
+        {
+            if (fits(lower, upper))
+                out[j/word_bits] |= Word{1} << (j % word_bits);
+            continue;
+        }
+        if (n != lanes.n_upper)
+            lanes.arrange(lower.gaps, n);
+        // Widen 8 gaps. The lanes past n aren't used. With n <= 8 the gaps are inline,
+        // so the load stays within the inline storage.
+        auto const perpends{_mm256_cvtepu16_epi32(_mm_loadu_si128(
+                reinterpret_cast<__m128i const*>(upper.perpends().begin())))};
+        auto const y{_mm256_cvtepi32_ps(
+                _mm256_add_epi32(perpends, _mm256_set1_epi32(upper.offset())))};
+        auto const d{static_cast<float>(lower.divisor(upper.period()).value())};
+        auto const dv{_mm256_set1_ps(d)};
+        auto const r{_mm256_set1_ps(1.0f/d)};
+        auto hit{false};
+        for (std::size_t c{0}; !hit && c < lanes.x.size(); ++c)
+        {
+            auto const index{_mm256_loadu_si256(
+                    reinterpret_cast<__m256i const*>(lanes.y[c].data()))};
+            auto const v{_mm256_sub_ps(_mm256_loadu_ps(lanes.x[c].data()),
+                                       _mm256_permutevar8x32_ps(y, index))};
+            auto const q{_mm256_round_ps(_mm256_mul_ps(v, r),
+                                         _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)};
+            auto const e{_mm256_fnmadd_ps(q, dv, v)};
+            hit = _mm256_movemask_ps(_mm256_cmp_ps(e, _mm256_setzero_ps(), _CMP_EQ_OQ)) != 0;
+        }
+        if (!hit)
+            out[j/word_bits] |= Word{1} << (j % word_bits);
+    }
+}
+#endif
+
+using Kernel = void (*)(Lower&, std::span<Row const>, std::span<Word>);
+
+// @return The kernel if the processor supports it, otherwise nullptr.
+Kernel supported(BatchKernel kernel)
+{
+#ifdef BRICKWORK_X86
+    __builtin_cpu_init();
+    // The AVX2 kernel also uses fused multiply-add, which is a separate feature.
+    if (kernel == BatchKernel::avx2)
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")
+            ? avx2_many : nullptr;
+    if (kernel == BatchKernel::sse4_1)
+        return __builtin_cpu_supports("sse4.1") ? sse_many : nullptr;
+#endif
+    return kernel == BatchKernel::scalar ? scalar_many : nullptr;
+}
+
+// @return The widest kernel the processor supports.
+Kernel choose_kernel()
+{
+    for (auto kernel : {BatchKernel::avx2, BatchKernel::sse4_1})
+        if (auto const f{supported(kernel)})
+            return f;
+    return scalar_many;
+}
+
+// The kernel set by force_batch_kernel(), if any.
+std::atomic<Kernel> forced_kernel{nullptr};
+}
+
+bool force_batch_kernel(BatchKernel kernel)
+{
+    if (kernel == BatchKernel::best)
+    {
+        forced_kernel = nullptr;
+        return true;
+    }
+    auto const f{supported(kernel)};
+    if (f)
+        forced_kernel = f;
+    return f != nullptr;
+}
+
+struct BatchScratch::Buffers
+{
+    Lower lower;
+};
+
+BatchScratch::BatchScratch()
+    : m_buffers{std::make_unique<Buffers>()}
+{}
+
+BatchScratch::~BatchScratch() = default;
+
+void is_brickwork_many(Row const& lower, std::span<Row const> uppers, std::span<Word> out,
+                       BatchScratch& scratch, PeriodTable const* table)
+{
+    static auto const best{choose_kernel()};
+    auto const forced{forced_kernel.load(std::memory_order_relaxed)};
+    std::fill(out.begin(), out.begin() + (uppers.size() + word_bits - 1)/word_bits, 0);
+    auto& prepared{scratch.buffers().lower};
+    prepared.prepare(lower, table);
+    (forced ? forced : best)(prepared, uppers, out);
+}
+
+void is_brickwork_many(Row const& lower, std::span<Row const> uppers, std::span<Word> out,
+                       PeriodTable const* table)
+{
+    BatchScratch scratch;
+    is_brickwork_many(lower, uppers, out, scratch, table);
+}
+
+std::vector<Word> is_brickwork_many(Row const& lower, std::span<Row const> uppers,
+                                    PeriodTable const* table)
+{
+    std::vector<Word> out((uppers.size() + word_bits - 1)/word_bits);
+    is_brickwork_many(lower, uppers, out, table);
+    return out;
+}
@@ -14,115 +14,1079 @@
 // If not, see <http://www.gnu.org/licenses/>.
 
 #include "brickwork.hh"
+#include "catalog.hh"
+#include "counter.hh"
+#include "hash.hh"
+#include "kernels.hh"
+#include "matrix.hh"
+#include "parallel.hh"
+#include "wall_store.hh"
 
 #include <algorithm>
-#include <cassert>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <functional>
 #include <numeric>
+#include <unordered_map>
+#include <utility>
 
-// A multi-place counter with a limited container-like interface.
-class Counter
+namespace
+{
+// @return True if no gaps in rows with positive periods line up. d is the gcd of the
+// periods.
+bool gaps_miss(Row const& lower, Row const& upper, Divisor const& d)
+{
+    // Gaps in the lower row are at b1 + x + a*X where x is a partial sum of the pattern,
+    // X is the period and a >= 0. Likewise for the upper row. By Bézout's identity,
+    // b1 + x + a*X = b2 + y + c*Y has a solution iff gcd(X, Y) divides b1 + x - b2 - y.
+    // The solution can always be shifted by multiples of the LCM to make a and c
+    // non-negative, so the rows line up iff any pair of partial sums satisfies that
+    // condition. The cost is independent of the LCM.
+    auto const db{lower.offset() - upper.offset()};
+    auto const& xs{lower.perpends()};
+    auto const& ys{upper.perpends()};
+    if (auto const check{gap_check(xs.size(), ys.size())})
+        return check(xs.begin(), ys.begin(), db, d);
+    return disjoint_gaps(xs.begin(), xs.size(), ys.begin(), ys.size(), db, d);
+}
+
+// Visit each wall that can be made by extending the partial wall. The partial wall has
+// at least one course and ends with the row at the previous index. Rows are tried in
+// catalog order so the walls come out in the order of a counter over all of the brick
+// widths. The last course must fit under the first as well as over the previous one. The
+// sorted indices of the rows that fit the first course are passed in as closers so they
+// can be reused for the whole search.
+void extend(Catalog const& catalog, int n_rows, int previous, std::vector<int> const& closers,
+            Wall& wall, WallVisitor const& visit)
+{
+    auto const course{static_cast<int>(wall.size())};
+    auto const parity{course % 2};
+    auto const& candidates{catalog.neighbors(1 - parity, previous)};
+    if (course == n_rows - 1)
+    {
+        // Walk the sorted lists together to find the rows that are in both.
+        auto it{closers.begin()};
+        for (auto index : candidates)
+        {
+            it = std::lower_bound(it, closers.end(), index);
+            if (it == closers.end())
+                break;
+            if (*it != index)
+                continue;
+            wall.push_back(catalog.row(parity, index));
+            visit(wall);
+            wall.pop_back();
+        }
+        return;
+    }
+    for (auto index : candidates)
+    {
+        wall.push_back(catalog.row(parity, index));
+        extend(catalog, n_rows, index, closers, wall, visit);
+        wall.pop_back();
+    }
+}
+
+// Visit each wall with the even row at the index as the first course.
+void search(Catalog const& catalog, int n_rows, int first, WallVisitor const& visit)
+{
+    Wall wall{catalog.row(0, first)};
+    extend(catalog, n_rows, first, catalog.neighbors(0, first), wall, visit);
+}
+
+// Buffers for a backtracking search that are reused at each step.
+struct BacktrackScratch
+{
+    BacktrackScratch(int n_rows, std::size_t n_candidates)
+        : fits(n_rows, std::vector<std::uint64_t>((n_candidates + word_bits - 1)/word_bits))
+    {}
+
+    // The bits for the candidates that fit each course.
+    std::vector<std::vector<std::uint64_t>> fits;
+    BatchScratch batch;
+};
+
+// Visit each wall that can be made by extending the partial wall. Each candidate row is
+// checked against the previous course as it's placed so that the whole subtree is
+// skipped if it doesn't fit. The rows that fit the first course are passed in as closers
+// so that the last course needs only one check.
+void backtrack(std::vector<Row> const (&rows)[2], PeriodTable const& table, int n_rows,
+               std::vector<Row const*> const& closers, Wall& wall,
+               BacktrackScratch& scratch, WallVisitor const& visit)
+{
+    auto const course{static_cast<int>(wall.size())};
+    auto const parity{course % 2};
+    if (course == n_rows - 1)
+    {
+        for (auto row : closers)
+            // With 2 courses, the previous course is the first.
+            if (course == 1 || is_brickwork(*row, wall.back(), table))
+            {
+                wall.push_back(*row);
+                visit(wall);
+                wall.pop_back();
+            }
+        return;
+    }
+    // Check all of the candidates at once.
+    auto& fits{scratch.fits[course]};
+    is_brickwork_many(wall.back(), rows[parity], fits, scratch.batch, &table);
+    for (std::size_t w{0}; w < fits.size(); ++w)
+        for (auto bits{fits[w]}; bits != 0; bits &= bits - 1)
+        {
+            wall.push_back(rows[parity][w*word_bits + std::countr_zero(bits)]);
+            backtrack(rows, table, n_rows, closers, wall, scratch, visit);
+            wall.pop_back();
+        }
+}
+
+// Visit each wall that extends the partial wall and comes first in its orbit under
+// symmetry. The indices of the courses so far are in indices, and reversed gives the index
+// of each catalog row's mirror image. See generate_canonical() for the symmetries.
+void extend_canonical(Catalog const& catalog, std::vector<int> const& reversed, int n_rows,
+                      std::vector<int>& indices, Wall& wall, OrbitVisitor const& visit)
+{
+    auto const course{static_cast<int>(indices.size())};
+    auto const parity{course % 2};
+    auto const last{course == n_rows - 1};
+    // The image of the wall that starts at this course with its rows mirrored if the
+    // shift is odd.
+    auto image = [&](int shift, int i) {
+        auto const index{indices[(i + shift) % n_rows]};
+        return shift % 2 == 0 ? index : reversed[index];
+    };
+
+    auto const& closers{catalog.neighbors(0, indices.front())};
+    auto it{closers.begin()};
+    for (auto index : catalog.neighbors(1 - parity, indices.back()))
+    {
+        // Reject the wall as soon as an image would start with an earlier row.
+        if ((parity == 0 ? index : reversed[index]) < indices.front())
+            continue;
+        if (last)
+        {
+            it = std::lower_bound(it, closers.end(), index);
+            if (it == closers.end())
+                break;
+            if (*it != index)
+                continue;
+        }
+        indices.push_back(index);
+        wall.push_back(catalog.row(parity, index));
+        if (!last)
+            extend_canonical(catalog, reversed, n_rows, indices, wall, visit);
+        else
+        {
+            // Compare the complete wall to each of its images.
+            auto stabilizer{1};
+            auto first{true};
+            for (auto shift{1}; first && shift < n_rows; ++shift)
+            {
+                auto i{0};
+                while (i < n_rows && image(shift, i) == indices[i])
+                    ++i;
+                if (i == n_rows)
+                    ++stabilizer;
+                else if (image(shift, i) < indices[i])
+                    first = false;
+            }
+            if (first)
+                visit(Orbit{wall, n_rows/stabilizer});
+        }
+        wall.pop_back();
+        indices.pop_back();
+    }
+}
+
+template <typename Item> using ItemVisitor = std::function<void(Item const&)>;
+
+// Visit the items held by one shard of a search in order.
+template <typename Item>
+void visit_items(std::vector<Item> const& items, ItemVisitor<Item> const& visit)
+{
+    for (auto const& item : items)
+        visit(item);
+}
+
+void visit_items(WallStore const& walls, WallVisitor const& visit)
+{
+    walls.visit(visit);
+}
+
+// Search from each of n first rows and visit the results in order. The search is called
+// with the index of the first row and a visitor for the items it finds. With more than
+// one thread, each search's items are held in a copy of the empty buffer until it's
+// their turn to be visited.
+template <typename Item, typename Buffer = std::vector<Item>>
+void search_in_order(int n, int n_threads,
+                     std::function<void(int, ItemVisitor<Item> const&)> const& search,
+                     std::type_identity_t<ItemVisitor<Item>> const& visit,
+                     Buffer const& empty = {})
+{
+    if (n_threads < 2)
+    {
+        for (auto i{0}; i < n; ++i)
+            search(i, visit);
+        return;
+    }
+
+    // Each first row starts a contiguous range of the counter over all widths. Search a
+    // batch of ranges in parallel and then visit the results in order.
+    auto const batch{4*n_threads};
+    for (auto first{0}; first < n; first += batch)
+    {
+        auto const n_shards{std::min(batch, n - first)};
+        std::vector<Buffer> shards(n_shards, empty);
+        for_each_shard(n_shards, n_threads, [&](int i) {
+            search(first + i,
+                   [&shard = shards[i]](Item const& item) { shard.push_back(item); });
+        });
+        for (auto const& shard : shards)
+            visit_items(shard, visit);
+    }
+}
+
+// Use backtracking instead of the compatibility graph if the graph could have more
+// edges than this.
+auto constexpr max_graph_pairs{std::int64_t{1} << 26};
+}
+
+std::vector<Wall> generate(int n_rows, int n_bricks, int widest_brick, int n_threads)
+{
+    std::vector<Wall> walls;
+    generate(n_rows, n_bricks, widest_brick,
+             [&walls](Wall const& wall) { walls.push_back(wall); }, n_threads);
+    return walls;
+}
+
+std::pmr::vector<Wall> generate(int n_rows, int n_bricks, int widest_brick,
+                                std::pmr::memory_resource* resource, int n_threads)
+{
+    // The vector passes its allocator to each wall it copies, and each wall to its rows.
+    std::pmr::vector<Wall> walls{resource};
+    generate(n_rows, n_bricks, widest_brick,
+             [&walls](Wall const& wall) { walls.push_back(wall); }, n_threads);
+    return walls;
+}
+
+void generate(int n_rows, int n_bricks, int widest_brick, WallVisitor const& visit,
+              int n_threads)
+{
+    // The first and last courses have the same offset if the number of courses is odd.
+    // Rows with the same offset always line up.
+    if (n_rows < 2 || n_rows % 2 != 0 || n_bricks < 1 || widest_brick < 2)
+        return;
+
+    if (uses_backtracking(n_bricks, widest_brick))
+    {
+        backtrack(n_rows, n_bricks, widest_brick, visit, n_threads);
+        return;
+    }
+
+    // Find the compatible rows once and then walk the graph.
+    Catalog const catalog(n_bricks, widest_brick, n_threads);
+    // The walls waiting their turn are packed.
+    search_in_order<Wall, WallStore>(
+        static_cast<int>(catalog.size()), n_threads,
+        [&](int first, WallVisitor const& v) { search(catalog, n_rows, first, v); },
+        visit, WallStore(n_rows, n_bricks, widest_brick));
+}
+
+void backtrack(int n_rows, int n_bricks, int widest_brick, WallVisitor const& visit,
+               int n_threads)
+{
+    if (n_rows < 2 || n_rows % 2 != 0 || n_bricks < 1 || widest_brick < 2)
+        return;
+
+    std::vector<Row> const rows[2]{make_rows(0, n_bricks, widest_brick),
+                                   make_rows(1, n_bricks, widest_brick)};
+    PeriodTable const table(n_bricks*widest_brick);
+    search_in_order<Wall, WallStore>(
+        static_cast<int>(rows[0].size()), n_threads,
+        [&](int first, WallVisitor const& v) {
+            Wall wall{rows[0][first]};
+            BacktrackScratch scratch(n_rows, std::max(rows[0].size(), rows[1].size()));
+            // The first course's bits aren't used by backtrack().
+            auto& fits{scratch.fits[0]};
+            is_brickwork_many(wall.front(), rows[1], fits, scratch.batch, &table);
+            std::vector<Row const*> closers;
+            for (std::size_t j{0}; j < rows[1].size(); ++j)
+                if ((fits[j/word_bits] >> (j % word_bits)) & 1)
+                    closers.push_back(&rows[1][j]);
+            backtrack(rows, table, n_rows, closers, wall, scratch, v);
+        },
+        visit, WallStore(n_rows, n_bricks, widest_brick));
+}
+
+void generate_canonical(int n_rows, int n_bricks, int widest_brick,
+                        OrbitVisitor const& visit, int n_threads)
+{
+    if (n_rows < 2 || n_rows % 2 != 0 || n_bricks < 1 || widest_brick < 2)
+        return;
+
+    Catalog const catalog(n_bricks, widest_brick, n_threads);
+    auto const n{static_cast<int>(catalog.size())};
+    std::vector<int> reversed(n);
+    for (auto i{0}; i < n; ++i)
+    {
+        auto const& pattern{catalog.row(0, i).pattern()};
+        reversed[i] = catalog.index(Pattern(std::reverse_iterator(pattern.end()),
+                                            std::reverse_iterator(pattern.begin())));
+    }
+    search_in_order<Orbit>(
+        n, n_threads,
+        [&](int first, OrbitVisitor const& v) {
+            std::vector<int> indices{first};
+            Wall wall{catalog.row(0, first)};
+            extend_canonical(catalog, reversed, n_rows, indices, wall, v);
+        },
+        visit);
+}
+
+namespace
+{
+// The distinct residues of a pattern's perpends modulo a divisor of its period, in
+// increasing order.
+using Residues = SmallVector<std::uint16_t, 16>;
+
+struct ResiduesHash
+{
+    std::size_t operator()(Residues const& residues) const
+    {
+        Fnv1a hash;
+        for (auto r : residues)
+            hash.add(r);
+        return hash.value();
+    }
+};
+
+// Patterns with the same residues modulo some divisor of their periods.
+struct ResidueClass
+{
+    Residues residues;
+    // The slot the patterns are counted in: their widest brick, or 0 if pairs aren't
+    // counted by width.
+    int slot;
+
+    bool operator==(ResidueClass const&) const = default;
+};
+
+struct ResidueClassHash
+{
+    std::size_t operator()(ResidueClass const& c) const
+    {
+        return ResiduesHash{}(c.residues) ^ static_cast<std::size_t>(c.slot);
+    }
+};
+
+// The number of patterns in each class.
+using ClassCounts = std::unordered_map<ResidueClass, std::uint64_t, ResidueClassHash>;
+
+// @return The Möbius function from 1 to n. Index 0 is unused.
+std::vector<int> mobius(int n)
+{
+    std::vector<int> mu(n + 1, 1);
+    std::vector<bool> composite(n + 1, false);
+    for (auto p{2}; p <= n; ++p)
+    {
+        if (composite[p])
+            continue;
+        for (auto k{p}; k <= n; k += p)
+        {
+            if (k > p)
+                composite[k] = true;
+            mu[k] = -mu[k];
+        }
+        auto const square{std::int64_t{p}*p};
+        for (auto k{square}; k <= n; k += square)
+            mu[k] = 0;
+    }
+    return mu;
+}
+
+// @return The residues plus 1 modulo d if up is true, otherwise minus 1.
+Residues shift(Residues const& residues, bool up, int d)
+{
+    std::vector<std::uint16_t> out(residues.begin(), residues.end());
+    for (auto& r : out)
+        r = up ? (r + 1 == d ? 0 : r + 1) : (r == 0 ? d - 1 : r - 1);
+    std::sort(out.begin(), out.end());
+    return Residues(out.begin(), out.end());
+}
+
+// Append the residues, plus 1 modulo d if up is true, as a bit mask of n_words words.
+void append_mask(Residues const& residues, bool up, int d, std::size_t n_words,
+                 std::vector<std::uint64_t>& masks)
+{
+    auto const first{masks.size()};
+    masks.resize(first + n_words);
+    for (auto r : residues)
+    {
+        auto const bit{static_cast<std::size_t>(up ? (r + 1 == d ? 0 : r + 1) : r)};
+        masks[first + bit/64] |= std::uint64_t{1} << (bit % 64);
+    }
+}
+
+// @return True if the bit masks of n_words words have no bits in common.
+bool disjoint(std::uint64_t const* lower, std::uint64_t const* upper, std::size_t n_words)
+{
+    for (std::size_t i{0}; i < n_words; ++i)
+        if (lower[i] & upper[i])
+            return false;
+    return true;
+}
+
+// The number of patterns whose residues contain each set of residues, by slot.
+class SupersetCounts
 {
 public:
-    // Initialize all digits of to n-place counter to the low value.
-    Counter(int n, int low, int high)
-        : m_low{low}, m_high{high}, m_sum{n*low}, m_v(n, low)
+    explicit SupersetCounts(std::size_t n_slots = 1)
+        : m_n_slots{n_slots}
     {}
 
-    // Increment the least significant place, possibly carrying or overflowing. This is
-    // the only way to change the count.
-    Counter& operator++();
-    // @return The sum of the digits.
-    int sum() const { return m_sum; }
-    // @return True if the counter has wrapped around to its initial state.
-    bool overflow() const { return m_overflow; }
-
-    // The container interface.
-    std::size_t size() const { return m_v.size(); }
-    auto operator[](std::size_t i) const { return m_v[i]; }
-    auto begin() const { return m_v.begin(); }
-    auto end() const { return m_v.end(); }
-    auto rbegin() const { return m_v.rbegin(); }
-    auto rend() const { return m_v.rend(); }
+    // Add count patterns in slot whose residues contain the set.
+    void add(Residues const& set, int slot, std::uint64_t count)
+    {
+        slot_counts(set)[slot] += count;
+    }
+    // Add all of the counts in other.
+    void merge(SupersetCounts const& other)
+    {
+        for (auto const& [set, i] : other.m_index)
+        {
+            auto const* from{other.m_counts.data() + i*m_n_slots};
+            auto* to{slot_counts(set)};
+            std::transform(from, from + m_n_slots, to, to, std::plus{});
+        }
+    }
+    // @return The counts by slot for the set, or nullptr if there are none.
+    std::uint64_t const* find(Residues const& set) const
+    {
+        auto const it{m_index.find(set)};
+        return it == m_index.end() ? nullptr : m_counts.data() + it->second*m_n_slots;
+    }
+    // Call f with each set and its counts by slot.
+    template <typename F> void for_each(F const& f) const
+    {
+        for (auto const& [set, i] : m_index)
+            f(set, m_counts.data() + i*m_n_slots);
+    }
 
 private:
-    int const m_low;  // The lowest value of a digit.
-    int const m_high; // The highest value of a digit.
-    int m_sum;  // The sum of the digits.
-    bool m_overflow{false}; // True if the counter has wrapped.
-    std::vector<int> m_v;  // The digits.
+    std::uint64_t* slot_counts(Residues const& set)
+    {
+        auto const [it, added]{m_index.try_emplace(set, m_index.size())};
+        if (added)
+            m_counts.resize(m_counts.size() + m_n_slots, 0);
+        return m_counts.data() + it->second*m_n_slots;
+    }
+
+    std::size_t m_n_slots;
+    std::unordered_map<Residues, std::size_t, ResiduesHash> m_index;
+    std::vector<std::uint64_t> m_counts;
+};
+
+// @return A hash of a set of residues modulo d that's the same for all of its rotations.
+// It depends only on the gaps between cyclically adjacent residues, so a set and the set
+// minus 1 always get the same hash.
+std::uint64_t rotation_hash(Residues const& set, int d)
+{
+    std::uint64_t hash{0};
+    for (std::size_t i{0}; i < set.size(); ++i)
+    {
+        auto const gap{i + 1 < set.size() ? set[i + 1] - set[i] : d - set[i] + set[0]};
+        // Sum a mix of each gap so the order of the gaps doesn't matter.
+        auto x{static_cast<std::uint64_t>(gap)*0x9e3779b97f4a7c15};
+        x = (x ^ (x >> 30))*0xbf58476d1ce4e5b9;
+        x = (x ^ (x >> 27))*0x94d049bb133111eb;
+        hash += x ^ (x >> 31);
+    }
+    return hash;
+}
+
+// The classes of the patterns with periods that are multiples of k*g, with residues
+// modulo g. Their fitting pairs are counted with the sign mu(k).
+//
+// Comparing every pair of classes is quadratic. By inclusion-exclusion over the sets U of
+// residues that both sides have, the number of disjoint pairs is the sum of (-1)^|U|
+// times the number of lower patterns with residues containing U, times the number of
+// upper patterns with residues containing U - 1. That takes 2^|S| steps for a class with
+// residues S, which is usually far less. But with many bricks, S can be large. Since the
+// sum is over pairs of classes, each class can take whichever way is cheaper: a class is
+// checked pairwise against all of the others if its subsets cost more than that. A pair
+// whose residues add up to more than d can't be disjoint, so it's skipped.
+struct Family
+{
+    int d;
+    std::uint64_t sign;
+    // The classes counted by inclusion-exclusion, then the ones checked pairwise by
+    // increasing number of residues.
+    std::vector<std::pair<ResidueClass, std::uint64_t>> classes;
+    // The number of classes counted by inclusion-exclusion.
+    std::size_t n_subsets{0};
+    // The number of classes checked pairwise with at most each number of residues.
+    std::vector<std::size_t> n_pairwise;
+    // The number of words in a bit mask of residues.
+    std::size_t n_words{0};
+    // Bit masks of the residues of each class, then of the residues plus 1. Only filled
+    // if there are pairwise classes.
+    std::vector<std::uint64_t> masks;
+    // The sum of 2^|S| over the residues S of the classes counted by inclusion-exclusion.
+    double subsets{0};
+    // The number of pairwise checks.
+    double checks{0};
+    // The sets of residues shared by those classes, split into parts. Indexed by chunk of
+    // classes, then by part.
+    std::vector<std::vector<SupersetCounts>> chunks;
+
+    // The cost of a subset relative to a pairwise check. A check is a few operations on
+    // bit masks. A subset is a hash table update and a lookup.
+    static double constexpr subset_cost{64};
+
+    // @return True if a class with the residues is checked pairwise in a family of n
+    // classes. It's checked as the lower and as the upper class of each pair.
+    static bool pairwise(Residues const& residues, std::size_t n)
+    {
+        return subset_cost*std::ldexp(1.0, static_cast<int>(residues.size()))
+            > 2*static_cast<double>(n);
+    }
+    // @return The first upper class that the lower class is checked against.
+    std::size_t first_upper(std::size_t lower) const
+    {
+        return lower < n_subsets ? n_subsets : 0;
+    }
+    // @return The end of the upper classes that the lower class is checked against.
+    std::size_t last_upper(std::size_t lower) const
+    {
+        if (n_pairwise.empty())
+            return n_subsets;
+        return n_subsets + n_pairwise[d - classes[lower].first.residues.size()];
+    }
+    // @return The relative cost of the pairwise checks.
+    double pairwise_work() const { return checks; }
+    // @return The relative cost of the inclusion-exclusion.
+    double subset_work() const { return subset_cost*subsets; }
 };
 
-Counter& Counter::operator++()
+// Add the number of pairs where the lower pattern is in classes first to last of the
+// family and its residues miss the upper pattern's residues plus 1 to out, by slot, times
+// the family's sign. That's when the rows fit if the gcd of their periods is the family's
+// divisor. Lower classes counted by inclusion-exclusion are only compared with the
+// pairwise upper classes. The rest of their pairs are counted by count_part().
+void count_pairwise(Family const& family, std::size_t first, std::size_t last,
+                    std::vector<std::uint64_t>& out)
+{
+    auto const& classes{family.classes};
+    auto const n_words{family.n_words};
+    for (auto i{first}; i < last; ++i)
+    {
+        auto const& [xs, x_count]{classes[i]};
+        auto const* lower{&family.masks[2*i*n_words]};
+        for (auto j{family.first_upper(i)}; j < family.last_upper(i); ++j)
+            if (disjoint(lower, &family.masks[(2*j + 1)*n_words], n_words))
+                out[std::max(xs.slot, classes[j].first.slot)]
+                    += family.sign*x_count*classes[j].second;
+    }
+}
+
+// Count the patterns in classes first to last of the family whose residues contain each
+// set into the family's chunk. Each set goes in the part given by its rotation hash.
+void count_subsets(Family& family, std::size_t chunk, std::size_t first, std::size_t last)
 {
-    // Adjust m_sum to avoid the need to sum over the digits.
-    for (auto& x : m_v)
+    auto& parts{family.chunks[chunk]};
+    std::vector<std::uint16_t> subset;
+    for (auto i{first}; i < last; ++i)
     {
-        if (x < m_high)
+        auto const& [c, count]{family.classes[i]};
+        auto const& residues{c.residues};
+        for (std::uint64_t mask{0}; mask < (std::uint64_t{1} << residues.size()); ++mask)
         {
-            ++x;
-            ++m_sum;
-            return *this;
+            subset.clear();
+            for (std::size_t j{0}; j < residues.size(); ++j)
+                if ((mask >> j) & 1)
+                    subset.push_back(residues[j]);
+            Residues const set(subset.begin(), subset.end());
+            auto const part{parts.size() == 1 ? 0
+                            : rotation_hash(set, family.d) % parts.size()};
+            parts[part].add(set, c.slot, count);
         }
-        x = m_low;
-        m_sum -= m_high - m_low;
     }
-    m_overflow = true;
-    return *this;
 }
 
-std::vector<Wall> generate(int n_rows, int n_bricks, int widest_brick)
+// Add the inclusion-exclusion terms for the sets in one part of the family to out, by
+// slot. See Family. A set and the set minus 1 are always in the same part.
+void count_part(Family& family, std::size_t part, std::vector<std::uint64_t>& out)
 {
-    std::vector<Wall> walls;
-    if (n_rows < 2 || n_bricks < 1 || widest_brick < 2)
-        return walls;
+    auto const n_slots{out.size()};
+    auto supersets{std::move(family.chunks.front()[part])};
+    for (auto chunk{family.chunks.begin() + 1}; chunk != family.chunks.end(); ++chunk)
+        supersets.merge((*chunk)[part]);
+    supersets.for_each([&](Residues const& u, std::uint64_t const* lower) {
+        auto const* upper{supersets.find(shift(u, false, family.d))};
+        if (!upper)
+            return;
+        auto const u_sign{u.size() % 2 == 0 ? family.sign : -family.sign};
+        // A pair is counted under the wider of its slots.
+        std::uint64_t lower_below{0};
+        std::uint64_t upper_through{0};
+        for (std::size_t w{0}; w < n_slots; ++w)
+        {
+            upper_through += upper[w];
+            out[w] += u_sign*(lower[w]*upper_through + lower_below*upper[w]);
+            lower_below += lower[w];
+        }
+    });
+}
+
+// A unit of work for one shard: a range of items in a piece of something at an index.
+struct Task
+{
+    double work;
+    std::size_t index;
+    std::size_t piece;
+    std::size_t first;
+    std::size_t last;
+};
+
+// @return The number of pairs of rows that fit indexed by the widest brick in the pair.
+// If by_width is false, all pairs are counted under widest_brick. That's faster since
+// there are fewer classes.
+std::vector<std::int64_t> count_pairs(int n_bricks, int widest_brick, bool by_width,
+                                      int n_threads)
+{
+    // Patterns x and y with periods X and Y don't fit iff some partial sums satisfy
+    // 1 - x + y = 0 (mod gcd(X, Y)). See is_brickwork(). So whether they fit depends only
+    // on the residues of their partial sums modulo the gcd. Rows with coprime periods
+    // never fit. For each g > 1, let F(k) be the number of fitting pairs, checked modulo
+    // g, of patterns with periods that are multiples of k*g. A pair with gcd h*g is in
+    // F(k) for each k that divides h, so by Möbius inversion over the divisor lattice,
+    // the sum of mu(k)*F(k) counts exactly the pairs with gcd g. Each F(k) depends only on
+    // the residues, so the patterns are grouped into classes that share them.
+    auto const max_period{n_bricks*widest_brick};
+    auto const n_slots{static_cast<std::size_t>(by_width ? widest_brick + 1 : 1)};
 
-    // Iterate over a flat vector of all the brick widths.
-    for (Counter widths(n_rows*n_bricks, 1, widest_brick); !widths.overflow(); ++widths)
+    // Bucket the widths of the patterns by period. Each shard enumerates an equal range
+    // of the patterns.
+    auto const n_patterns{Counter(n_bricks, 1, widest_brick).total()};
+    auto const n_shards{std::max(n_threads, 1)};
+    using Buckets = std::vector<std::vector<std::uint8_t>>;
+    std::vector<Buckets> shards(n_shards, Buckets(max_period + 1));
+    for_each_shard(n_shards, n_threads, [&](int shard) {
+        auto& by_period{shards[shard]};
+        auto const first{n_patterns*shard/n_shards};
+        auto const last{n_patterns*(shard + 1)/n_shards};
+        Counter widths(n_bricks, 1, widest_brick, first);
+        for (auto i{first}; i < last; ++i, ++widths)
+            by_period[widths.sum()].insert(by_period[widths.sum()].end(),
+                                           widths.begin(), widths.end());
+    });
+    auto& by_period{shards.front()};
+    for (auto shard{shards.begin() + 1}; shard != shards.end(); ++shard)
+        for (auto period{1}; period <= max_period; ++period)
+            by_period[period].insert(by_period[period].end(), (*shard)[period].begin(),
+                                     (*shard)[period].end());
+
+    // The rest is done in passes of tasks. The tasks in a pass are handed out costliest
+    // first, and each adds to its own counts.
+    std::vector<std::uint64_t> counts(n_slots, 0);
+    auto const run{[&](std::vector<Task>& tasks, auto const& f) {
+        std::sort(tasks.begin(), tasks.end(),
+                  [](Task const& t1, Task const& t2) { return t1.work > t2.work; });
+        std::vector<std::vector<std::uint64_t>> task_counts(tasks.size());
+        for_each_shard(static_cast<int>(tasks.size()), n_threads, [&](int shard) {
+            std::vector<std::uint64_t> out(n_slots, 0);
+            f(tasks[shard], out);
+            task_counts[shard] = std::move(out);
+        });
+        for (auto const& out : task_counts)
+            std::transform(out.begin(), out.end(), counts.begin(), counts.begin(),
+                           std::plus{});
+    }};
+
+    // Each gcd g has about n/g patterns with periods that are multiples of it, but each
+    // has up to 2^min(n_bricks, g) subsets of residues, so the costliest gcds are
+    // mid-range. Count the gcds in batches of about equal estimated work so that only one
+    // batch's classes and subsets are held at a time.
+    auto const n_batches{8};
+    std::vector<std::pair<double, int>> estimates;
+    double total_estimate{0};
+    for (auto g{2}; g <= max_period; ++g)
+    {
+        std::size_t n_multiples{0};
+        for (auto period{g}; period <= max_period; period += g)
+            n_multiples += by_period[period].size()/n_bricks;
+        estimates.emplace_back(std::ldexp(static_cast<double>(n_multiples),
+                                          std::min(n_bricks, g)), g);
+        total_estimate += estimates.back().first;
+    }
+    std::sort(estimates.begin(), estimates.end(), std::greater{});
+    std::vector<std::vector<int>> batches(1);
+    double estimate{0};
+    for (auto const& [work, g] : estimates)
     {
-        // Use revere iterators to place most significant (slowest changing) bricks first.
-        Wall wall{Row{0, std::vector(widths.rbegin(), widths.rbegin() + n_bricks)}};
-        for (auto row_num{1}; row_num < n_rows; ++row_num)
+        if (estimate >= total_estimate*static_cast<double>(batches.size())/n_batches)
+            batches.emplace_back();
+        batches.back().push_back(g);
+        estimate += work;
+    }
+
+    auto const mu{mobius(max_period)};
+    for (auto const& batch : batches)
+    {
+        // Find the classes of the patterns with each period m*g modulo each g in the
+        // batch. Each task takes one period and one of its divisors.
+        std::vector<std::vector<ClassCounts>> by_multiple(max_period + 1);
+        std::vector<Task> tasks;
+        for (auto g : batch)
+        {
+            by_multiple[g].resize(max_period/g + 1);
+            for (auto m{1}; m*g <= max_period; ++m)
+                if (!by_period[m*g].empty())
+                    tasks.push_back({static_cast<double>(by_period[m*g].size()),
+                                     static_cast<std::size_t>(g),
+                                     static_cast<std::size_t>(m), 0, 0});
+        }
+        run(tasks, [&](Task const& task, std::vector<std::uint64_t>&) {
+            auto const g{static_cast<int>(task.index)};
+            auto const m{static_cast<int>(task.piece)};
+            Divisor const d(g);
+            auto& classes{by_multiple[g][m]};
+            std::vector<std::uint16_t> residues;
+            auto const& widths{by_period[m*g]};
+            for (auto first{widths.begin()}; first != widths.end(); first += n_bricks)
+            {
+                residues.clear();
+                for (auto i{0}, x{0}; i < n_bricks; x += first[i++])
+                    residues.push_back(static_cast<std::uint16_t>(d.residue(x)));
+                std::sort(residues.begin(), residues.end());
+                residues.erase(std::unique(residues.begin(), residues.end()),
+                               residues.end());
+                auto const slot{by_width ? *std::max_element(first, first + n_bricks)
+                                         : 0};
+                ++classes[{Residues(residues.begin(), residues.end()), slot}];
+            }
+        });
+
+        // Gather the classes of each family, one task per family.
+        std::vector<Family> families;
+        tasks.clear();
+        for (auto g : batch)
+            for (auto k{1}; k*g <= max_period; ++k)
+            {
+                if (mu[k] == 0)
+                    continue;
+                std::size_t n_classes{0};
+                for (auto m{k}; m*g <= max_period; m += k)
+                    n_classes += by_multiple[g][m].size();
+                if (n_classes == 0)
+                    continue;
+                tasks.push_back({static_cast<double>(n_classes), families.size(),
+                                 static_cast<std::size_t>(k), 0, 0});
+                families.push_back(
+                    {g, static_cast<std::uint64_t>(mu[k]), {}, 0, {}, 0, {}, 0, 0, {}});
+            }
+        run(tasks, [&](Task const& task, std::vector<std::uint64_t>&) {
+            auto& family{families[task.index]};
+            auto const g{family.d};
+            auto const k{static_cast<int>(task.piece)};
+            ClassCounts merged;
+            for (auto m{k}; m*g <= max_period; m += k)
+                for (auto const& [c, count] : by_multiple[g][m])
+                    merged[c] += count;
+            family.classes.assign(merged.begin(), merged.end());
+            auto const n_classes{family.classes.size()};
+            auto const pairwise{std::partition(
+                family.classes.begin(), family.classes.end(), [n_classes](auto const& c) {
+                    return !Family::pairwise(c.first.residues, n_classes);
+                })};
+            family.n_subsets = static_cast<std::size_t>(pairwise
+                                                        - family.classes.begin());
+            for (auto c{family.classes.begin()}; c != pairwise; ++c)
+                family.subsets
+                    += std::ldexp(1.0, static_cast<int>(c->first.residues.size()));
+            std::sort(pairwise, family.classes.end(), [](auto const& c1, auto const& c2) {
+                return c1.first.residues.size() < c2.first.residues.size();
+            });
+            // Classes with residues in common share most of their subsets. Keeping them
+            // together keeps the chunks' sets from overlapping.
+            std::sort(family.classes.begin(), pairwise,
+                      [](auto const& c1, auto const& c2) {
+                          return std::lexicographical_compare(
+                              c1.first.residues.begin(), c1.first.residues.end(),
+                              c2.first.residues.begin(), c2.first.residues.end());
+                      });
+            if (pairwise != family.classes.end())
+            {
+                family.n_pairwise.assign(g + 1, 0);
+                for (auto c{pairwise}; c != family.classes.end(); ++c)
+                    ++family.n_pairwise[c->first.residues.size()];
+                std::partial_sum(family.n_pairwise.begin(), family.n_pairwise.end(),
+                                 family.n_pairwise.begin());
+                family.n_words = static_cast<std::size_t>(g + 63)/64;
+                for (std::size_t i{0}; i < n_classes; ++i)
+                {
+                    auto const& residues{family.classes[i].first.residues};
+                    append_mask(residues, false, g, family.n_words, family.masks);
+                    append_mask(residues, true, g, family.n_words, family.masks);
+                    family.checks += static_cast<double>(family.last_upper(i)
+                                                         - family.first_upper(i));
+                }
+            }
+        });
+        by_multiple.clear();
+
+        // Split each family into pieces of about the same work, with enough pieces that
+        // the largest is a small fraction of the batch. The pairwise checks are split by
+        // ranges of lower classes. The inclusion-exclusion is split by ranges of classes
+        // to find the subsets, then by parts of the subsets to count them.
+        double total_work{0};
+        for (auto const& family : families)
+            total_work += family.pairwise_work() + family.subset_work();
+        auto const piece_work{total_work/(4*n_shards)};
+        auto const n_pieces{[&](double work, std::size_t n) {
+            return n_shards < 2 ? std::size_t{1}
+                : std::clamp(static_cast<std::size_t>(std::ceil(work/piece_work)),
+                             std::size_t{1}, std::max(n, std::size_t{1}));
+        }};
+        tasks.clear();
+        std::vector<Task> subset_tasks;
+        std::vector<Task> part_tasks;
+        for (std::size_t f{0}; f < families.size(); ++f)
         {
-            Row row{row_num % 2,
-                std::vector(widths.rbegin() + row_num*n_bricks,
-                            widths.rbegin() + (row_num + 1)*n_bricks)};
-            // Add this row if it fits with the previous row.
-            if (is_brickwork(row, wall.back()))
+            auto& family{families[f]};
+            auto const n_classes{family.classes.size()};
+            if (auto const work{family.pairwise_work()}; work > 0)
+            {
+                // Split the lower classes by the number of upper classes they're
+                // compared with.
+                auto const n{n_pieces(work, n_classes)};
+                std::size_t first{0};
+                double done{0};
+                for (std::size_t piece{0}; piece < n; ++piece)
+                {
+                    auto last{first};
+                    auto const end{work*static_cast<double>(piece + 1)/n};
+                    for (; last < n_classes && (piece + 1 == n || done < end); ++last)
+                        done += static_cast<double>(family.last_upper(last)
+                                                    - family.first_upper(last));
+                    tasks.push_back({work/n, f, piece, first, last});
+                    first = last;
+                }
+            }
+            if (family.n_subsets == 0)
+                continue;
+            // Split the classes by their numbers of subsets.
+            auto const work{family.subset_work()};
+            auto const n{n_pieces(work, family.n_subsets)};
+            family.chunks.assign(n,
+                                 std::vector<SupersetCounts>(n, SupersetCounts(n_slots)));
+            std::size_t first{0};
+            double subsets{0};
+            for (std::size_t chunk{0}; chunk < n; ++chunk)
             {
-                wall.push_back(row);
-                if (static_cast<int>(wall.size()) == n_rows)
-                    break;
+                auto last{first};
+                auto const end{family.subsets*static_cast<double>(chunk + 1)/n};
+                for (; last < family.n_subsets && (chunk + 1 == n || subsets < end);
+                     ++last)
+                {
+                    auto const& residues{family.classes[last].first.residues};
+                    subsets += std::ldexp(1.0, static_cast<int>(residues.size()));
+                }
+                subset_tasks.push_back({work/n, f, chunk, first, last});
+                first = last;
             }
+            for (std::size_t part{0}; part < n; ++part)
+                part_tasks.push_back({work/n, f, part, 0, 0});
         }
-        // Add the wall if we found enough rows and the 1st row fits on top of the last
-        // row.
-        if (static_cast<int>(wall.size()) == n_rows
-            && is_brickwork(wall.front(), wall.back()))
-            walls.push_back(wall);
+        // The pairwise checks don't depend on the subsets, so they share a pass.
+        for (auto& task : subset_tasks)
+            task.index += families.size();
+        tasks.insert(tasks.end(), subset_tasks.begin(), subset_tasks.end());
+        run(tasks, [&](Task const& task, std::vector<std::uint64_t>& out) {
+            if (task.index < families.size())
+                count_pairwise(families[task.index], task.first, task.last, out);
+            else
+                count_subsets(families[task.index - families.size()], task.piece,
+                              task.first, task.last);
+        });
+        run(part_tasks, [&](Task const& task, std::vector<std::uint64_t>& out) {
+            count_part(families[task.index], task.piece, out);
+        });
     }
-    return walls;
+
+    std::vector<std::int64_t> out(widest_brick + 1);
+    for (std::size_t w{0}; w < n_slots; ++w)
+        out[by_width ? w : widest_brick] += static_cast<std::int64_t>(counts[w]);
+    return out;
 }
 
-int num_brickworks(int n_rows, int n_bricks, int widest_brick)
+// @return The transfer matrix from an even course to the next even course using the rows
+// in the catalog with no brick wider than widest_brick. Element (i, k) is the number of
+// odd rows that fit between the ith and kth of those even rows. With the catalog's own
+// widest brick, the indices are the catalog's.
+Matrix transfer_matrix(Catalog const& catalog, int widest_brick)
 {
-    assert(n_rows == 2 && "Calculation has not been generalized.");
+    auto const n{catalog.size()};
+    // The index of each catalog row in the matrix, or -1 if it's left out. The even and
+    // odd rows have the same patterns in the same order.
+    std::vector<int> position(n, -1);
+    auto size{0};
+    for (std::size_t i{0}; i < n; ++i)
+    {
+        auto const& pattern{catalog.row(0, i).pattern()};
+        if (std::all_of(pattern.begin(), pattern.end(),
+                        [widest_brick](auto width) { return width <= widest_brick; }))
+            position[i] = size++;
+    }
 
-    auto is_wall = [](auto const& xs, auto const& ys) {
-        auto const d{std::gcd(xs.sum(), ys.sum())};
-        auto const i_max{static_cast<int>(xs.size())};
-        auto const j_max{static_cast<int>(ys.size())};
-        for (auto i{0}, x{0}; i < i_max; x += xs[i++])
-            for (auto j{0}, y{0}; j < j_max; y += ys[j++])
-                if ((1 - x + y) % d == 0)
-                    return false;
-        return true;
-    };
+    Matrix m(size);
+    for (std::size_t j{0}; j < n; ++j)
+    {
+        if (position[j] < 0)
+            continue;
+        auto const& evens{catalog.neighbors(1, j)};
+        for (auto i : evens)
+            if (position[i] >= 0)
+                for (auto k : evens)
+                    if (position[k] >= 0)
+                        ++m(position[i], position[k]);
+    }
+    return m;
+}
+
+// @return The trace of the product of two powers of the same symmetric matrix. They're
+// symmetric, so it's the sum of the products of the elements.
+std::uint64_t trace_product(Matrix const& a, Matrix const& b)
+{
+    std::uint64_t out{0};
+    for (std::size_t i{0}; i < a.size(); ++i)
+        for (std::size_t j{0}; j < a.size(); ++j)
+            out += a(i, j)*b(i, j);
+    return out;
+}
+
+// @return The trace of the symmetric matrix m to the power of k >= 1.
+std::uint64_t trace_power(Matrix const& m, int k)
+{
+    // Get the trace from the product of two lower powers.
+    return trace_product(power(m, (k + 1)/2), power(m, k/2));
+}
+
+// @return The number of closed walks of length n_rows in the compatibility graph of the
+// catalog's rows with no brick wider than widest_brick.
+std::int64_t count_cycles(int n_rows, Catalog const& catalog, int widest_brick)
+{
+    // The number of walls is the trace of m^(n_rows/2).
+    return trace_power(transfer_matrix(catalog, widest_brick), n_rows/2);
+}
+}
+
+std::int64_t num_brickworks(int n_rows, int n_bricks, int widest_brick, int n_threads)
+{
+    // As in generate(), there are no walls with an odd number of courses.
+    if (n_rows < 2 || n_rows % 2 != 0 || n_bricks < 1 || widest_brick < 2)
+        return 0;
+    // Avoid building the catalog for the common case.
+    if (n_rows == 2)
+        return count_pairs(n_bricks, widest_brick, false, n_threads).back();
+    if (uses_backtracking(n_bricks, widest_brick))
+        return backtrack_sweep_num_brickworks(n_rows, n_bricks, widest_brick,
+                                              n_threads).back();
+    return count_cycles(n_rows, Catalog(n_bricks, widest_brick, n_threads), widest_brick);
+}
+
+std::vector<std::int64_t> sweep_num_brickworks(int n_rows, int n_bricks, int widest_brick,
+                                               int n_threads)
+{
+    std::vector<std::int64_t> out(std::max(widest_brick + 1, 0), 0);
+    if (n_rows < 2 || n_rows % 2 != 0 || n_bricks < 1 || widest_brick < 2)
+        return out;
+    if (n_rows == 2)
+    {
+        // Each pair was counted under its widest brick. It's also in the counts for all
+        // wider bricks.
+        auto const counts{count_pairs(n_bricks, widest_brick, true, n_threads)};
+        std::partial_sum(counts.begin(), counts.end(), out.begin());
+        return out;
+    }
+    if (uses_backtracking(n_bricks, widest_brick))
+        return backtrack_sweep_num_brickworks(n_rows, n_bricks, widest_brick, n_threads);
+    // The rows with narrower bricks are a subset of the catalog.
+    Catalog const catalog(n_bricks, widest_brick, n_threads);
+    for (auto widest{2}; widest <= widest_brick; ++widest)
+        out[widest] = count_cycles(n_rows, catalog, widest);
+    return out;
+}
+
+std::vector<std::int64_t> backtrack_sweep_num_brickworks(int n_rows, int n_bricks,
+                                                         int widest_brick, int n_threads)
+{
+    // Count each wall under its widest brick, then accumulate as for 2 courses.
+    std::vector<std::int64_t> counts(std::max(widest_brick + 1, 0), 0);
+    backtrack(n_rows, n_bricks, widest_brick,
+              [&counts](Wall const& wall) {
+                  auto widest{0};
+                  for (auto const& row : wall)
+                      for (auto width : row.pattern())
+                          widest = std::max(widest, static_cast<int>(width));
+                  ++counts[widest];
+              },
+              n_threads);
+    std::partial_sum(counts.begin(), counts.end(), counts.begin());
+    return counts;
+}
 
-    auto out{0};
-    for(Counter x_widths(n_bricks, 1, widest_brick); !x_widths.overflow(); ++x_widths)
-        for(Counter y_widths(n_bricks, 1, widest_brick); !y_widths.overflow(); ++y_widths)
-            if (is_wall(x_widths, y_widths))
-                ++out;
+bool uses_backtracking(int n_bricks, int widest_brick)
+{
+    auto const n_catalog{std::pow(widest_brick, n_bricks)};
+    return n_catalog*n_catalog > max_graph_pairs;
+}
+
+std::vector<GridCount> grid_num_brickworks(Range rows, Range bricks, Range widest,
+                                           int n_threads)
+{
+    std::vector<GridCount> out;
+    auto const add{[&](int n_rows, int n_bricks, auto const& counts) {
+        for (auto w{widest.first}; w <= widest.last; ++w)
+            out.push_back({n_rows, n_bricks, w, w < 0 ? 0 : counts[w]});
+    }};
+    for (auto n_bricks{bricks.first}; n_bricks <= bricks.last; ++n_bricks)
+    {
+        // The 2-course counts for all widths come from one sieve. Courses don't change
+        // the pairs, so the other counts share a catalog and a transfer matrix m for each
+        // width. The count for 2k courses is the trace of m^k, the sum of the products of
+        // the elements of m^(k - 1) and m. Each m^(k - 1) is the last one times m.
+        auto const backtracking{uses_backtracking(n_bricks, widest.last)};
+        auto const first_width{std::max(widest.first, 2)};
+        auto const first_even{std::max(rows.first + rows.first % 2, 4)};
+        std::vector<Matrix> matrices;
+        std::vector<Matrix> powers;
+        if (first_even <= rows.last && n_bricks >= 1 && first_width <= widest.last
+            && !backtracking)
+        {
+            Catalog const catalog(n_bricks, widest.last, n_threads);
+            for (auto w{first_width}; w <= widest.last; ++w)
+                matrices.push_back(transfer_matrix(catalog, w));
+        }
+        for (auto n_rows{rows.first}; n_rows <= rows.last; ++n_rows)
+        {
+            std::vector<std::int64_t> counts(std::max(widest.last + 1, 0), 0);
+            if (n_rows == 2 || backtracking)
+                counts = sweep_num_brickworks(n_rows, n_bricks, widest.last, n_threads);
+            else if (n_rows > 2 && n_rows % 2 == 0 && !matrices.empty())
+                for (std::size_t i{0}; i < matrices.size(); ++i)
+                {
+                    if (powers.size() == i)
+                        powers.push_back(power(matrices[i], n_rows/2 - 1));
+                    else
+                        powers[i] = powers[i]*matrices[i];
+                    counts[first_width + i] = trace_product(powers[i], matrices[i]);
+                }
+            add(n_rows, n_bricks, counts);
+        }
+    }
+    std::sort(out.begin(), out.end());
     return out;
 }
 
@@ -130,29 +1094,55 @@ bool is_brickwork(Row const& lower, Row const& upper)
 {
     if (lower.period() <= 0 || upper.period() <= 0)
         return false;
+    return gaps_miss(lower, upper, Divisor(std::gcd(lower.period(), upper.period())));
+}
+
+bool is_brickwork(Row const& lower, Row const& upper, PeriodTable const& table)
+{
+    if (lower.period() <= 0 || upper.period() <= 0)
+        return false;
+    return gaps_miss(lower, upper, table.gcd_divisor(lower.period(), upper.period()));
+}
 
-    // The two-row pattern repeats after the least common multiple of the total lengths of
-    // the pattern. If there are no aligned gaps by that point, there will be no aligned
-    // gaps.
-    auto const n_to_check{std::lcm(lower.period(), upper.period())};
-    auto const b1{lower.offset()};
-    auto const b2{upper.offset()};
-
-    auto const& p1{lower.pattern()};
-    auto const& p2{upper.pattern()};
-    auto x1{b1};
-    auto x2{b2};
-    auto i1{0u};
-    auto i2{0u};
-    // Keep going until the rows line up or we've checked enough to know that they won't.
-    while (x1 != x2 && (x1 < b1 + n_to_check || x2 < b2 + n_to_check))
-    {
-        // Leapfrog: Advance x1 until it meets or passes x2...
-        while (x1 < x2)
-            x1 += p1[i1++ % p1.size()];
-        // ... then advance x2 until it meets or passes x1.
-        while (x2 < x1)
-            x2 += p2[i2++ % p1.size()];
-    }
-    return x1 != x2;
+SymmetryCount num_canonical_brickworks(int n_rows, int n_bricks, int widest_brick)
+{
+    if (n_rows < 2 || n_rows % 2 != 0 || n_bricks < 1 || widest_brick < 2)
+        return {0, 0};
+
+    Catalog const catalog(n_bricks, widest_brick);
+    auto const m{transfer_matrix(catalog, widest_brick)};
+    // Count the walls left unchanged by each symmetry. By Burnside's lemma, the number
+    // of orbits is the average.
+    std::uint64_t total{0};
+    std::uint64_t raw{0};
+    for (auto shift{0}; shift < n_rows; ++shift)
+    {
+        // The shift fixes the same walls as its gcd with the number of courses since
+        // they generate the same subgroup.
+        auto const d{std::gcd(shift, n_rows)};
+        std::uint64_t fixed{0};
+        if (d % 2 == 0)
+            // An even shift fixes the walls that repeat every d courses.
+            fixed = trace_power(m, d/2);
+        else
+        {
+            // An odd shift fixes the walls where each course is the mirror image of the
+            // one d courses above, so course d is the first course reversed. Count
+            // the walks of d - 1 steps from each even row r to an even row that fits the
+            // odd mirror image of r.
+            auto const walks{power(m, (d - 1)/2)};
+            for (auto r{0}; r < static_cast<int>(catalog.size()); ++r)
+            {
+                auto const& pattern{catalog.row(0, r).pattern()};
+                auto const mirror{catalog.index(Pattern(std::reverse_iterator(pattern.end()),
+                                                        std::reverse_iterator(pattern.begin())))};
+                for (auto e : catalog.neighbors(1, mirror))
+                    fixed += walks(r, e);
+            }
+        }
+        if (shift == 0)
+            raw = fixed;
+        total += fixed;
+    }
+    return {static_cast<std::int64_t>(total/n_rows), static_cast<std::int64_t>(raw)};
 }
@@ -16,20 +16,168 @@
 #ifndef BRICKWORK_HH
 #define BRICKWORK_HH
 
+#include "period_table.hh"
 #include "wall.hh"
 
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <span>
 #include <vector>
 
 /// @return a vector will all possible brickworks of n_rows rows consisting of a pattern
 /// of n_bricks from 1 to widest_brick units wide. The bricks in a pattern do not
-/// necessarily have unique widths.
-std::vector<Wall> generate(int n_rows, int n_bricks, int widest_brick);
+/// necessarily have unique widths. The search is split across up to n_threads threads.
+/// The order of the walls does not depend on the number of threads. widest_brick must be
+/// at most max_brick_width, and n_bricks*widest_brick at most max_row_period. The same
+/// limits apply to the other functions here.
+std::vector<Wall> generate(int n_rows, int n_bricks, int widest_brick, int n_threads = 1);
+/// Like above, but allocate the walls, their rows, and any long row patterns from the
+/// memory resource. A std::pmr::monotonic_buffer_resource makes allocation a pointer bump
+/// and frees everything at once when the run is done. The resource is only used from the
+/// calling thread, so it needn't be thread-safe. With more than one thread, walls found
+/// out of turn are held as packed keys on the default heap, not in the resource, and
+/// decoded into the resource when it's their turn.
+std::pmr::vector<Wall> generate(int n_rows, int n_bricks, int widest_brick,
+                                std::pmr::memory_resource* resource, int n_threads = 1);
+/// Like above, but pass each wall to the visitor as soon as it's found instead of
+/// storing it. The walls are visited in the same order. With multiple threads, only the
+/// walls from a few first courses are held at a time.
+void generate(int n_rows, int n_bricks, int widest_brick, WallVisitor const& visit,
+              int n_threads = 1);
+
+/// Visit the same walls as generate() in the same order, but find them by backtracking:
+/// each course is checked against the one before as it's placed, and if it doesn't fit,
+/// no walls that start with those courses are tried. The compatibility graph is not
+/// built, so memory does not grow with the square of the number of rows. generate()
+/// uses this when the graph would be too large.
+void backtrack(int n_rows, int n_bricks, int widest_brick, WallVisitor const& visit,
+               int n_threads = 1);
+
+/// A wall that stands for its orbit under the wall symmetries.
+struct Orbit
+{
+    Wall wall;
+    /// The number of walls in the orbit.
+    int size;
+};
+/// A function that's called with each orbit as it's found.
+using OrbitVisitor = std::function<void(Orbit const&)>;
+
+/// Visit one wall from each orbit of the walls from generate() under the symmetries of
+/// walls, along with the size of the orbit. The symmetries are generated by shifting the
+/// courses down by one and mirroring the rows. Mirroring swaps the laps of even and odd
+/// courses, and the shift swaps them back. Shifting down two courses without mirroring
+/// follows. The representative is the first wall of the orbit in generate() order. Other
+/// walls are rejected during the search, mostly as soon as the course that would start a
+/// lower image is placed.
+void generate_canonical(int n_rows, int n_bricks, int widest_brick,
+                        OrbitVisitor const& visit, int n_threads = 1);
+
+/// The numbers of walls with and without reduction by symmetry.
+struct SymmetryCount
+{
+    /// The number of orbits.
+    std::int64_t canonical;
+    /// The number of walls.
+    std::int64_t raw;
+};
+
+/// @return The number of walls generate_canonical() would visit and the number of walls
+/// generate() would visit. The number of orbits is calculated from the transfer matrix
+/// with Burnside's lemma.
+SymmetryCount num_canonical_brickworks(int n_rows, int n_bricks, int widest_brick);
 
 /// @return True if the two rows don't have any gaps that line up.
 bool is_brickwork(Row const& lower, Row const& upper);
+/// @return The same as above, but take the gcd of the periods and its reciprocal from the
+/// table, which must cover both periods.
+bool is_brickwork(Row const& lower, Row const& upper, PeriodTable const& table);
+/// The number of bits in each word of is_brickwork_many()'s output.
+std::size_t constexpr word_bits{64};
+
+/// The buffers is_brickwork_many() prepares the lower row in. Passing the same scratch to
+/// each call, such as one for each search, reuses them. Once they've grown to fit the
+/// rows, the calls don't allocate.
+class BatchScratch
+{
+public:
+    BatchScratch();
+    ~BatchScratch();
+
+    /// The buffers, defined where they're used.
+    struct Buffers;
+    Buffers& buffers() { return *m_buffers; }
+
+private:
+    std::unique_ptr<Buffers> m_buffers;
+};
+
+/// Check the lower row against each of the upper rows. Bit j % 64 of word j/64 of out is
+/// set if is_brickwork(lower, uppers[j]). The first (uppers.size() + 63)/64 words of out
+/// are overwritten. The lower row is prepared once in the scratch buffers and the upper
+/// rows are checked several at a time with the widest vector instructions the processor
+/// supports. If a table is given, it must cover the periods of all of the rows.
+/// Otherwise, the gcds are worked out during the call.
+void is_brickwork_many(Row const& lower, std::span<Row const> uppers,
+                       std::span<std::uint64_t> out, BatchScratch& scratch,
+                       PeriodTable const* table = nullptr);
+/// The same as above, but with buffers that are allocated for the call.
+void is_brickwork_many(Row const& lower, std::span<Row const> uppers,
+                       std::span<std::uint64_t> out, PeriodTable const* table = nullptr);
+/// @return The bits described above.
+std::vector<std::uint64_t> is_brickwork_many(Row const& lower, std::span<Row const> uppers,
+                                             PeriodTable const* table = nullptr);
+
+/// @return The number of walls generate() would produce, calculated without generating
+/// them. For more than 2 courses, the count is the trace of a power of the row transfer
+/// matrix. Counts that don't fit in 64 bits wrap. The work is split across up to
+/// n_threads threads.
+std::int64_t num_brickworks(int n_rows, int n_bricks, int widest_brick, int n_threads = 1);
+
+/// @return The number of walls num_brickworks() gives for each widest brick up to
+/// widest_brick, indexed by the widest brick. The work is shared: for 2 courses, each
+/// pair of rows is counted once under the widest brick it uses and the counts are
+/// accumulated. For more courses, one catalog is built and the narrower rows are picked
+/// out of it. The cost is about the same as the count for widest_brick alone.
+std::vector<std::int64_t> sweep_num_brickworks(int n_rows, int n_bricks, int widest_brick,
+                                               int n_threads = 1);
+/// @return The same counts as sweep_num_brickworks(), found by counting the walls from
+/// backtrack() under their widest bricks. The time grows with the number of walls, but
+/// memory doesn't grow with the square of the number of rows.
+std::vector<std::int64_t> backtrack_sweep_num_brickworks(int n_rows, int n_bricks,
+                                                         int widest_brick,
+                                                         int n_threads = 1);
+/// @return True if the compatibility graph or transfer matrix of the rows would be too
+/// large to build. Then generate() uses backtrack(), and num_brickworks() and
+/// sweep_num_brickworks() use backtrack_sweep_num_brickworks() for more than 2 courses.
+bool uses_backtracking(int n_bricks, int widest_brick);
+
+/// An inclusive range of parameter values.
+struct Range
+{
+    int first;
+    int last;
+};
+
+/// The number of walls for one set of parameters.
+struct GridCount
+{
+    int n_rows;
+    int n_bricks;
+    int widest_brick;
+    std::int64_t count;
+
+    auto operator<=>(GridCount const&) const = default;
+};
 
-/// @return Calculated number of brickworks. Currently only implemented for 2 rows and 2
-/// bricks. These values are asserted.
-int num_brickworks(int n_rows, int n_bricks, int widest_brick);
+/// @return The num_brickworks() counts for every combination of parameters in the
+/// ranges, ordered by number of courses, number of bricks, and widest brick. Work is
+/// shared between the combinations: the rows for each number of bricks are found once for
+/// the widest brick, and each transfer matrix is used for all numbers of courses.
+std::vector<GridCount> grid_num_brickworks(Range rows, Range bricks, Range widest,
+                                           int n_threads = 1);
 
 #endif // BRICKWORK_HH
@@ -0,0 +1,51 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "catalog.hh"
+#include "counter.hh"
+
+std::vector<Row> make_rows(int offset, int n_bricks, int widest_brick)
+{
+    std::vector<Row> rows;
+    // Use reverse iterators to put the most significant (slowest changing) digits first.
+    for (Counter widths(n_bricks, 1, widest_brick); !widths.overflow(); ++widths)
+        rows.emplace_back(offset, widths.rbegin(), widths.rend());
+    return rows;
+}
+
+Catalog::Catalog(int n_bricks, int widest_brick, int n_threads)
+    : m_widest_brick{widest_brick},
+      m_rows{make_rows(0, n_bricks, widest_brick), make_rows(1, n_bricks, widest_brick)},
+      m_compat{m_rows[0], m_rows[1], n_threads}
+{
+    auto const n{size()};
+    m_neighbors[0].resize(n);
+    m_neighbors[1].resize(n);
+    // Visit the even rows in order so the odd rows' lists come out sorted.
+    for (std::size_t i{0}; i < n; ++i)
+        m_compat.for_each(i, [this, i](std::size_t j) {
+            m_neighbors[0][i].push_back(static_cast<int>(j));
+            m_neighbors[1][j].push_back(static_cast<int>(i));
+        });
+}
+
+int Catalog::index(Pattern const& pattern) const
+{
+    // The index is the value of the counter with the first brick most significant.
+    auto out{0};
+    for (auto width : pattern)
+        out = out*m_widest_brick + width - 1;
+    return out;
+}
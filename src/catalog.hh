@@ -0,0 +1,68 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef CATALOG_HH
+#define CATALOG_HH
+
+#include "compat_matrix.hh"
+#include "wall.hh"
+
+#include <cstddef>
+#include <vector>
+
+/// All rows with a pattern of n_bricks from 1 to widest_brick units wide, with an offset
+/// of 0 (even courses) or 1 (odd courses), and the compatibility graph between them.
+/// Rows are indexed in lexicographic order of their patterns, which is the order in
+/// which a counter over the brick widths visits them. The same index refers to the same
+/// pattern in both parities.
+class Catalog
+{
+public:
+    /// Build the catalog, checking compatibility on up to n_threads threads.
+    Catalog(int n_bricks, int widest_brick, int n_threads = 1);
+
+    /// @return The number of rows of each parity.
+    std::size_t size() const { return m_rows[0].size(); }
+    /// @return The row at the index with an offset equal to the parity.
+    Row const& row(int parity, int index) const { return m_rows[parity][index]; }
+    /// @return The index of the pattern, which must have n_bricks bricks from 1 to
+    /// widest_brick units wide.
+    int index(Pattern const& pattern) const;
+    /// @return The indices of the rows of the opposite parity that fit with the row of
+    /// the given parity and index, in increasing order.
+    std::vector<int> const& neighbors(int parity, int index) const
+    {
+        return m_neighbors[parity][index];
+    }
+    /// @return The compatibility of each even row (matrix row) with each odd row (matrix
+    /// column).
+    CompatMatrix const& compatibility() const { return m_compat; }
+
+private:
+    /// The widest brick.
+    int m_widest_brick;
+    /// The rows with offsets 0 and 1.
+    std::vector<Row> m_rows[2];
+    /// The compatibility of the even rows with the odd rows.
+    CompatMatrix m_compat;
+    /// The adjacency lists for even and odd rows.
+    std::vector<std::vector<int>> m_neighbors[2];
+};
+
+/// @return All rows with a pattern of n_bricks from 1 to widest_brick units wide with
+/// the given offset, in catalog order.
+std::vector<Row> make_rows(int offset, int n_bricks, int widest_brick);
+
+#endif // CATALOG_HH
@@ -0,0 +1,96 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "compat_matrix.hh"
+#include "brickwork.hh"
+#include "parallel.hh"
+#include "period_table.hh"
+
+#include <algorithm>
+
+namespace
+{
+// The size of the blocks of pairs checked together. The column rows of a block stay in
+// cache while each of the block's rows is checked against them.
+std::size_t constexpr tile_rows{64};
+std::size_t constexpr tile_columns{512};
+static_assert(tile_columns % CompatMatrix::word_bits == 0);
+// The matrix's rows are filled directly by is_brickwork_many().
+static_assert(CompatMatrix::word_bits == word_bits);
+}
+
+CompatMatrix::CompatMatrix(std::vector<Row> const& rows, std::vector<Row> const& columns,
+                           int n_threads)
+    : m_rows{rows.size()},
+      m_columns{columns.size()},
+      m_stride{(m_columns + cache_line*8 - 1)/(cache_line*8)*(cache_line/sizeof(Word))},
+      m_bits(m_rows*m_stride, 0)
+{
+    // One table of gcds is shared by all of the checks.
+    auto max_period{0};
+    for (auto const* set : {&rows, &columns})
+        for (auto const& row : *set)
+            max_period = std::max(max_period, row.period());
+    PeriodTable const table(max_period);
+
+    // Each shard is a band of whole rows of bits so no two threads write to the same
+    // cache line.
+    auto const n_bands{static_cast<int>((m_rows + tile_rows - 1)/tile_rows)};
+    for_each_shard(n_bands, n_threads, [&](int band) {
+        auto const first{band*tile_rows};
+        auto const last{std::min(m_rows, first + tile_rows)};
+        BatchScratch scratch;
+        for (std::size_t j0{0}; j0 < m_columns; j0 += tile_columns)
+        {
+            auto const j_last{std::min(m_columns, j0 + tile_columns)};
+            // Tiles start on word boundaries so each row's bits can be written directly.
+            std::span<Row const> const tile{columns.data() + j0, j_last - j0};
+            for (auto i{first}; i < last; ++i)
+                is_brickwork_many(rows[i], tile,
+                                  {m_bits.data() + i*m_stride + j0/word_bits,
+                                   m_stride - j0/word_bits},
+                                  scratch, &table);
+        }
+    });
+}
+
+std::size_t CompatMatrix::count(std::size_t i) const
+{
+    std::size_t out{0};
+    for (auto word : row(i))
+        out += std::popcount(word);
+    return out;
+}
+
+std::size_t CompatMatrix::count_common(std::size_t i, std::size_t k) const
+{
+    auto const a{row(i)};
+    auto const b{row(k)};
+    std::size_t out{0};
+    for (std::size_t w{0}; w < m_stride; ++w)
+        out += std::popcount(a[w] & b[w]);
+    return out;
+}
+
+std::size_t CompatMatrix::count_common(std::size_t i, std::size_t k,
+                                       std::span<Word const> mask) const
+{
+    auto const a{row(i)};
+    auto const b{row(k)};
+    std::size_t out{0};
+    for (std::size_t w{0}; w < m_stride; ++w)
+        out += std::popcount(a[w] & b[w] & mask[w]);
+    return out;
+}
@@ -0,0 +1,108 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef COMPAT_MATRIX_HH
+#define COMPAT_MATRIX_HH
+
+#include "wall.hh"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <vector>
+
+/// The size of a cache line in bytes.
+std::size_t constexpr cache_line{64};
+
+/// An allocator that puts each block at the start of a cache line.
+template <typename T> struct CacheAlignedAllocator
+{
+    using value_type = T;
+
+    CacheAlignedAllocator() = default;
+    template <typename U> CacheAlignedAllocator(CacheAlignedAllocator<U> const&) {}
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(::operator new(n*sizeof(T), std::align_val_t{cache_line}));
+    }
+    void deallocate(T* p, std::size_t)
+    {
+        ::operator delete(p, std::align_val_t{cache_line});
+    }
+    template <typename U> bool operator==(CacheAlignedAllocator<U> const&) const
+    {
+        return true;
+    }
+};
+
+/// The is_brickwork() relation between two sets of rows, stored one bit per pair. Each
+/// row of bits starts on a cache line, so rows filled by different threads don't share
+/// lines. Row i has bit j set if rows[i] and columns[j] fit.
+class CompatMatrix
+{
+public:
+    using Word = std::uint64_t;
+    /// The number of bits in a word.
+    static std::size_t constexpr word_bits{64};
+
+    /// Check each pair of rows on up to n_threads threads.
+    CompatMatrix(std::vector<Row> const& rows, std::vector<Row> const& columns,
+                 int n_threads = 1);
+
+    std::size_t rows() const { return m_rows; }
+    std::size_t columns() const { return m_columns; }
+    /// @return The number of words in each row of bits, including padding. Padding bits
+    /// are never set.
+    std::size_t words() const { return m_stride; }
+
+    /// @return True if rows[i] and columns[j] fit.
+    bool operator()(std::size_t i, std::size_t j) const
+    {
+        return (row(i)[j/word_bits] >> (j % word_bits)) & 1;
+    }
+    /// @return The bits for rows[i].
+    std::span<Word const> row(std::size_t i) const
+    {
+        return {m_bits.data() + i*m_stride, m_stride};
+    }
+    /// @return The number of columns that fit rows[i].
+    std::size_t count(std::size_t i) const;
+    /// @return The number of columns that fit both rows[i] and rows[k].
+    std::size_t count_common(std::size_t i, std::size_t k) const;
+    /// @return The number of columns with bits set in the mask that fit both rows[i] and
+    /// rows[k]. The mask must have words() words.
+    std::size_t count_common(std::size_t i, std::size_t k,
+                             std::span<Word const> mask) const;
+    /// Call f(j) for each column j that fits rows[i] in increasing order.
+    template <typename F> void for_each(std::size_t i, F const& f) const
+    {
+        auto const bits{row(i)};
+        for (std::size_t w{0}; w < bits.size(); ++w)
+            for (auto word{bits[w]}; word != 0; word &= word - 1)
+                f(w*word_bits + std::countr_zero(word));
+    }
+
+private:
+    std::size_t m_rows;
+    std::size_t m_columns;
+    /// The number of words per row, rounded up to a whole number of cache lines.
+    std::size_t m_stride;
+    std::vector<Word, CacheAlignedAllocator<Word>> m_bits;
+};
+
+#endif // COMPAT_MATRIX_HH
@@ -0,0 +1,77 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "counter.hh"
+
+Counter& Counter::operator++()
+{
+    // Adjust m_sum to avoid the need to sum over the digits.
+    for (auto& x : m_v)
+    {
+        if (x < m_high)
+        {
+            ++x;
+            ++m_sum;
+            return *this;
+        }
+        x = m_low;
+        m_sum -= m_high - m_low;
+    }
+    m_overflow = true;
+    return *this;
+}
+
+Counter::Counter(int n, int low, int high, std::uint64_t index)
+    : Counter(n, low, high)
+{
+    *this += index;
+}
+
+Counter& Counter::operator+=(std::uint64_t k)
+{
+    // Add k digit-by-digit in base (high - low + 1).
+    std::uint64_t const base(m_high - m_low + 1);
+    for (auto& x : m_v)
+    {
+        if (k == 0)
+            return *this;
+        auto const sum{x - m_low + k % base};
+        k = k/base + sum/base;
+        m_sum -= x;
+        x = m_low + static_cast<int>(sum % base);
+        m_sum += x;
+    }
+    if (k > 0)
+        m_overflow = true;
+    return *this;
+}
+
+std::uint64_t Counter::rank() const
+{
+    std::uint64_t const base(m_high - m_low + 1);
+    std::uint64_t index{0};
+    for (auto it{rbegin()}; it != rend(); ++it)
+        index = index*base + (*it - m_low);
+    return index;
+}
+
+std::uint64_t Counter::total() const
+{
+    std::uint64_t const base(m_high - m_low + 1);
+    std::uint64_t n{1};
+    for (std::size_t i{0}; i < size(); ++i)
+        n *= base;
+    return n;
+}
@@ -0,0 +1,66 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef COUNTER_HH
+#define COUNTER_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// A multi-place counter with a limited container-like interface. The first digit is the
+/// least significant. Linear indices count from 0 with all digits at the low value. They
+/// must fit in 64 bits.
+class Counter
+{
+public:
+    /// Initialize all digits of to n-place counter to the low value.
+    Counter(int n, int low, int high)
+        : m_low{low}, m_high{high}, m_sum{n*low}, m_v(n, low)
+    {}
+    /// Initialize the counter to the linear index. The counter overflows if the index is
+    /// not less than total().
+    Counter(int n, int low, int high, std::uint64_t index);
+
+    /// Increment the least significant place, possibly carrying or overflowing.
+    Counter& operator++();
+    /// Advance by k steps in O(n) time. Equivalent to k increments.
+    Counter& operator+=(std::uint64_t k);
+    /// @return The linear index of the current digits.
+    std::uint64_t rank() const;
+    /// @return The number of distinct values, (high - low + 1)^n.
+    std::uint64_t total() const;
+    /// @return The sum of the digits.
+    int sum() const { return m_sum; }
+    /// @return True if the counter has wrapped around to its initial state.
+    bool overflow() const { return m_overflow; }
+
+    // The container interface.
+    std::size_t size() const { return m_v.size(); }
+    auto operator[](std::size_t i) const { return m_v[i]; }
+    auto begin() const { return m_v.begin(); }
+    auto end() const { return m_v.end(); }
+    auto rbegin() const { return m_v.rbegin(); }
+    auto rend() const { return m_v.rend(); }
+
+private:
+    int const m_low;  // The lowest value of a digit.
+    int const m_high; // The highest value of a digit.
+    int m_sum;  // The sum of the digits.
+    bool m_overflow{false}; // True if the counter has wrapped.
+    std::vector<int> m_v;  // The digits.
+};
+
+#endif // COUNTER_HH
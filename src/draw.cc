@@ -15,9 +15,12 @@
 
 #include "draw.hh"
 
-#include "simple_svg_1.0.0.hpp"
+#include "row_table.hh"
+#include "svg_stream.hh"
 
 #include <optional>
+#include <string>
+#include <vector>
 
 auto constexpr height_unit{9}; // Rendered length of a brick of length 1.
 auto constexpr length_unit{10}; // Rendered height of a brick.
@@ -36,15 +39,15 @@ svg::Color brick_red(int darkness)
 }
 
 /// Draw a single brick.
-svg::Document& draw_brick(svg::Document& st_svg, int x, int y, int length,
-                          std::optional<svg::Color> color = std::nullopt)
+SvgStream& draw_brick(SvgStream& st_svg, int x, int y, int length,
+                      std::optional<svg::Color> color = std::nullopt)
 {
     return st_svg << svg::Rectangle(svg::Point(x, y), length*length_unit - gap,
                                     height_unit, color ? *color : brick_red(length));
 }
 
 /// Draw a repeating row of bricks.
-svg::Document& draw_row(svg::Document& st_svg, Row const& row, int y, int max_width)
+SvgStream& draw_row(SvgStream& st_svg, Row const& row, int y, int max_width)
 {
     auto x{0};
     if (row.offset() != 0)
@@ -52,20 +55,19 @@ svg::Document& draw_row(svg::Document& st_svg, Row const& row, int y, int max_wi
         draw_brick(st_svg, x, y, row.offset(), offset_color);
         x += row.offset()*length_unit;
     }
+    if (row.period() <= 0)
+        return st_svg;
+    auto const& pattern{row.pattern()};
+    auto const& perpends{row.perpends()};
     // Add 1 to avoid anti-aliasing artifacts at the edge.
-    while (x < max_width + 1)
-    {
-        for (auto p : row.pattern())
-        {
-            draw_brick(st_svg, x, y, p);
-            x += p*length_unit;
-        }
-    }
+    for (; x < max_width + 1; x += row.period()*length_unit)
+        for (std::size_t i{0}; i < pattern.size(); ++i)
+            draw_brick(st_svg, x + perpends[i]*length_unit, y, pattern[i]);
     return st_svg;
 }
 
-svg::Document& draw_wall(svg::Document& st_svg, Wall const& courses,
-                         int y, int width, int n_courses)
+SvgStream& draw_wall(SvgStream& st_svg, Wall const& courses,
+                     int y, int width, int n_courses)
 {
     // Draw the courses backwards so the base is a the bottom (largest y coordinate).
     for (auto i{n_courses}; i-- > 0; y += row_height)
@@ -73,35 +75,92 @@ svg::Document& draw_wall(svg::Document& st_svg, Wall const& courses,
     return st_svg;
 }
 
-svg::Document svg_stream(std::string const& file, int width, int height)
+/// Place a wall by reference to row symbols. A row is defined as a symbol the first time
+/// it appears. The symbol name is based on the row's ID in the table of rows seen so far
+/// and is kept in names, indexed by ID.
+SvgStream& use_wall(SvgStream& st_svg, Wall const& courses, int y, int width,
+                    int n_courses, RowTable& rows, std::vector<std::string>& names)
+{
+    for (auto i{n_courses}; i-- > 0; y += row_height)
+    {
+        auto const& row{courses[i % courses.size()]};
+        auto const id{rows.intern(row)};
+        if (id == names.size())
+        {
+            names.push_back("r" + std::to_string(id));
+            st_svg.begin_symbol(names.back());
+            draw_row(st_svg, row, 0, width);
+            st_svg.end_symbol();
+        }
+        st_svg.use(names[id], 0, y);
+    }
+    return st_svg;
+}
+
+/// Draw the mortar background.
+SvgStream& draw_background(SvgStream& st_svg, int width, int height)
 {
-    svg::Document st_svg(file, svg::Layout(svg::Dimensions(width, height),
-                                           svg::Layout::TopLeft));
     // Add 1 to width and height to avoid anti-aliasing artifacts.
     return st_svg << svg::Rectangle(svg::Point(0, 0), width + 1, height + 1, mortar_color);
 }
 
+// @return A source that visits each wall in the vector.
+WallSource vector_source(std::vector<Wall> const& walls)
+{
+    return [&walls](WallVisitor const& visit) {
+        for (auto const& wall : walls)
+            visit(wall);
+    };
+}
+
 void svg_walls(std::string const& file,
-               int const width, std::vector<Wall> const& walls, int n_courses)
+               int const width, std::vector<Wall> const& walls, int n_courses,
+               bool symbols)
+{
+    svg_walls(file, width, walls.size(), vector_source(walls), n_courses, symbols);
+}
+
+void svg_walls(std::string const& file, int const width, std::size_t n_walls,
+               WallSource const& source, int n_courses, bool symbols)
 {
     // The total number of rows includes a separator row between each wall.
-    auto const total_rows {walls.empty() ? 0 : (n_courses + 1)*walls.size() - 1};
-    auto st_svg{svg_stream(file, width, total_rows*row_height)};
-    for (int y{0}; auto const& wall : walls)
-    {
-        draw_wall(st_svg, wall, y, width, n_courses);
+    auto const total_rows {n_walls == 0 ? 0 : (n_courses + 1)*n_walls - 1};
+    auto const height{static_cast<int>(total_rows*row_height)};
+    SvgStream st_svg(file, svg::Layout(svg::Dimensions(width, height), svg::Layout::TopLeft),
+                     symbols);
+    draw_background(st_svg, width, height);
+    RowTable rows;
+    std::vector<std::string> names;
+    source([&, y = 0](Wall const& wall) mutable {
+        if (symbols)
+            use_wall(st_svg, wall, y, width, n_courses, rows, names);
+        else
+            draw_wall(st_svg, wall, y, width, n_courses);
         y += (n_courses + 1)*row_height;
-    }
-    st_svg.save();
+    });
+    st_svg.close();
 }
 
 std::ostream& ascii_walls(std::ostream& os, std::vector<Wall> const& walls, int n_courses)
 {
-    for (auto const& wall : walls)
-    {
+    return ascii_walls(os, vector_source(walls), n_courses);
+}
+
+std::ostream& ascii_walls(std::ostream& os, WallSource const& source, int n_courses)
+{
+    // Make the text for each distinct row once.
+    RowTable rows;
+    std::vector<std::string> text;
+    source([&](Wall const& wall) {
         for (int i{n_courses}; i-- > 0;)
-            os << wall[i % wall.size()] << '\n';
+        {
+            auto const& row{wall[i % wall.size()]};
+            auto const id{rows.intern(row)};
+            if (id == text.size())
+                text.push_back(std::string(row));
+            os << text[id] << '\n';
+        }
         os << '\n';
-    }
+    });
     return os;
 }
@@ -18,15 +18,24 @@
 
 #include "wall.hh"
 
+#include <cstddef>
 #include <iosfwd>
 #include <string>
 #include <vector>
 
-/// Render an SVG image of the walls to file.
+/// Render an SVG image of the walls to file. If symbols is true, each distinct row is
+/// drawn once as a symbol and the walls are made of references to the symbols. This
+/// makes a much smaller file when rows appear in many walls.
 void svg_walls(std::string const& file, int const width, std::vector<Wall> const& walls,
-               int n_courses);
+               int n_courses, bool symbols = false);
+/// Render an SVG image of the walls from the source to file. The image is sized for
+/// n_walls walls, which should be the number the source produces.
+void svg_walls(std::string const& file, int const width, std::size_t n_walls,
+               WallSource const& source, int n_courses, bool symbols = false);
 
 /// Send an ASCII rendering of the wall to the stream.
 std::ostream& ascii_walls(std::ostream& os, std::vector<Wall> const& walls, int n_courses);
+/// Send an ASCII rendering of the walls from the source to the stream.
+std::ostream& ascii_walls(std::ostream& os, WallSource const& source, int n_courses);
 
 #endif
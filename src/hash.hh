@@ -0,0 +1,40 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HASH_HH
+#define HASH_HH
+
+#include <cstddef>
+#include <cstdint>
+
+/// A 64-bit FNV-1a hash of a sequence of integers with a final mix of the high bits into
+/// the low ones. Equal sequences give equal hashes.
+class Fnv1a
+{
+public:
+    /// Add the next integer.
+    Fnv1a& add(std::uint64_t x)
+    {
+        m_state = (m_state ^ x)*0x100000001b3;
+        return *this;
+    }
+    /// @return The hash of the integers added so far.
+    std::size_t value() const { return static_cast<std::size_t>(m_state ^ (m_state >> 29)); }
+
+private:
+    std::uint64_t m_state{0xcbf29ce484222325};
+};
+
+#endif // HASH_HH
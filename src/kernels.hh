@@ -0,0 +1,110 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef KERNELS_HH
+#define KERNELS_HH
+
+#include "period_table.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+/// A check for gaps that line up. Takes the lower and upper gap positions within their
+/// periods, stored in 16 bits as in Perpends, the lower row's offset minus the upper
+/// row's, and the gcd of the periods.
+/// Returns true if no lower gap plus the shift is congruent to an upper gap modulo the
+/// gcd. The counts of gaps are implied by the kernel.
+using GapCheck = bool (*)(std::uint16_t const* lower, std::uint16_t const* upper, int shift,
+                          Divisor const& d);
+
+/// The largest number of gaps with a specialized kernel.
+std::size_t constexpr max_kernel_gaps{6};
+
+namespace detail
+{
+/// The check for N lower and M upper gaps. Each gap is reduced at most once. The upper
+/// gaps are reduced while they're compared with the first lower gap, then the other
+/// lower gaps are compared with the stored residues. Residues are found with the
+/// divisor's reciprocal, so there are no division instructions at all. The folds
+/// unroll the loops completely, and the comparisons stop at the first match.
+template <std::size_t N, std::size_t M>
+bool disjoint_gaps(std::uint16_t const* lower, std::uint16_t const* upper, int shift,
+                   Divisor const& d)
+{
+    // Everything is congruent modulo 1. Coprime periods are common.
+    if (d.value() == 1)
+        return false;
+    return [&]<std::size_t... I, std::size_t... J>(std::index_sequence<I...>,
+                                                     std::index_sequence<J...>) {
+        std::array<int, M> y;
+        auto const first{d.residue(shift + lower[0])};
+        if (((first == (y[J] = d.residue(upper[J]))) || ...))
+            return false;
+        auto const none_equal{[&y](int r) { return ((r != y[J]) && ...); }};
+        return (none_equal(d.residue(shift + lower[I + 1])) && ...);
+    }(std::make_index_sequence<N - 1>{}, std::make_index_sequence<M>{});
+}
+
+/// @return The table of kernels indexed by the numbers of gaps minus 1.
+template <std::size_t... I> constexpr auto make_kernels(std::index_sequence<I...>)
+{
+    auto const row{[]<std::size_t N, std::size_t... J>(std::index_sequence<J...>) {
+        return std::array<GapCheck, sizeof...(J)>{disjoint_gaps<N, J + 1>...};
+    }};
+    return std::array{row.template operator()<I + 1>(std::index_sequence<I...>{})...};
+}
+
+inline auto constexpr kernels{make_kernels(std::make_index_sequence<max_kernel_gaps>{})};
+}
+
+/// The check for any numbers of gaps. Slower than the specialized kernels.
+inline bool disjoint_gaps(std::uint16_t const* lower, std::size_t n_lower,
+                          std::uint16_t const* upper, std::size_t n_upper, int shift,
+                          Divisor const& d)
+{
+    for (std::size_t i{0}; i < n_lower; ++i)
+        for (std::size_t j{0}; j < n_upper; ++j)
+            if (d.divides(shift + lower[i] - upper[j]))
+                return false;
+    return true;
+}
+
+/// @return The specialized kernel for the numbers of gaps, or nullptr if there isn't one
+/// and the general disjoint_gaps() must be used. The kernel is called indirectly, but
+/// since each gap is reduced at most once, it's still faster than the general loop.
+inline GapCheck gap_check(std::size_t n_lower, std::size_t n_upper)
+{
+    if (n_lower < 1 || n_lower > max_kernel_gaps || n_upper < 1 || n_upper > max_kernel_gaps)
+        return nullptr;
+    return detail::kernels[n_lower - 1][n_upper - 1];
+}
+
+/// The kernels for is_brickwork_many(). best is the widest one the processor supports.
+enum class BatchKernel
+{
+    best,
+    scalar,
+    sse4_1,
+    avx2
+};
+
+/// Make is_brickwork_many() use the kernel so that each can be tested. Pass best to go
+/// back to the default. @return False, with no change, if the processor doesn't support
+/// the kernel.
+bool force_batch_kernel(BatchKernel kernel);
+
+#endif // KERNELS_HH
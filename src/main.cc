@@ -15,13 +15,21 @@
 
 #include "brickwork.hh"
 #include "draw.hh"
+#include "necklace.hh"
 #include "wall.hh"
 
 #include <getopt.h>
 
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <optional>
+#include <string>
+#include <thread>
 #include <vector>
 
 auto constexpr info{
@@ -36,14 +44,34 @@ auto constexpr usage{
     "                 specified, a text file.\n"
     "    -c --count   Output the number of walls. Nothing is rendered, even if other\n"
     "                  output-related options are given.\n"
+    "    -C --canonical\n"
+    "                 Keep one wall from each set of walls that are the same up to\n"
+    "                 shifting courses and mirroring. With --count, output the number\n"
+    "                 of such sets and the total number of walls.\n"
+    "    -g --grid=   Output a table of wall counts for every combination of courses,\n"
+    "                 bricks, and max_brick in the given ranges. The format is 'csv' or\n"
+    "                 'json'. Nothing is rendered.\n"
     "    -h --help    Display this message and exit.\n"
+    "    -j --threads=\n"
+    "                 The number of threads to use for the search. Defaults to the\n"
+    "                 number of cores.\n"
+    "    -n --necklaces\n"
+    "                 List the canonical row patterns, each the smallest rotation of\n"
+    "                 a primitive pattern, with the number of raw patterns each\n"
+    "                 stands for. With --count, output the number of fitting pairs\n"
+    "                 of canonical patterns and the raw count. 2 courses only.\n"
     "    -o --output= File name for the rendering sans extension. Defaults to\n"
     "                 'brickwork'. An extension is appended, .svg or .txt, depending\n"
     "                 on other options.\n"
+    "    -s --symbols Define each distinct row once in the SVG file and place walls\n"
+    "                 by reference. Gives much smaller files for many walls.\n"
+    "    -S --sweep   Output the number of walls for each maximum brick width from 1 to\n"
+    "                 max_brick, one width and count per line. Nothing is rendered.\n"
     "\n"
     "    courses      The number of repeated rows of bricks. Must be even.\n"
     "    bricks       The number of repeated bricks in each course.\n"
-    "    max_brick    The maximum brick width.\n"
+    "    max_brick    The maximum brick width, at most 255.\n"
+    "                 With --grid, each may be a range, e.g. 2-6.\n"
     "\n"
     "If neither --ascii nor --count is given, an SVG image file is produced.\n"
 };
@@ -53,11 +81,48 @@ struct Options
     int n_rows{2};
     int n_bricks{2};
     int widest_brick{2};
+    // The parameter ranges for --grid. The single values above are the first values.
+    Range rows{2, 2};
+    Range bricks{2, 2};
+    Range widest{2, 2};
+    std::optional<std::string> grid;
     bool render{true};
     bool ascii{false};
+    bool symbols{false};
+    bool necklaces{false};
+    bool canonical{false};
+    bool sweep{false};
+    // hardware_concurrency() is 0 if the number of cores can't be found.
+    int n_threads{std::max(static_cast<int>(std::thread::hardware_concurrency()), 1)};
     std::optional<std::string> output;
 };
 
+// @return The range given by a single number or two numbers separated by '-', or no
+// value if the argument is not of that form or the range is empty.
+std::optional<Range> read_range(char const* arg)
+{
+    auto const read_number{[](char const*& p) -> std::optional<int> {
+        if (!std::isdigit(static_cast<unsigned char>(*p)))
+            return std::nullopt;
+        char* end;
+        auto const n{std::strtol(p, &end, 10)};
+        p = end;
+        if (n > std::numeric_limits<int>::max())
+            return std::nullopt;
+        return static_cast<int>(n);
+    }};
+    auto p{arg};
+    auto const first{read_number(p)};
+    if (!first)
+        return std::nullopt;
+    auto last{first};
+    if (*p == '-')
+        last = read_number(++p);
+    if (!last || *p != '\0' || *last < *first)
+        return std::nullopt;
+    return Range{*first, *last};
+}
+
 Options read_options(int argc, char** argv)
 {
     Options opt;
@@ -65,12 +130,18 @@ Options read_options(int argc, char** argv)
     {
         static struct option options[] = {
             {"ascii", no_argument, nullptr, 'a'},
+            {"canonical", no_argument, nullptr, 'C'},
             {"count-only", no_argument, nullptr, 'c'},
             {"output", required_argument, nullptr, 'o'},
+            {"grid", required_argument, nullptr, 'g'},
             {"help", no_argument, nullptr, 'h'},
+            {"necklaces", no_argument, nullptr, 'n'},
+            {"symbols", no_argument, nullptr, 's'},
+            {"sweep", no_argument, nullptr, 'S'},
+            {"threads", required_argument, nullptr, 'j'},
             {0, 0, 0, 0}};
         int index;
-        auto c{getopt_long(argc, argv, "aco:h", options, &index)};
+        auto c{getopt_long(argc, argv, "aCco:g:hj:nsS", options, &index)};
         if (c == -1)
             break;
         switch (c)
@@ -80,12 +151,37 @@ Options read_options(int argc, char** argv)
         case 'a':
             opt.ascii = true;
             break;
+        case 'C':
+            opt.canonical = true;
+            break;
         case 'c':
             opt.render = false;
             break;
         case 'o':
             opt.output = optarg;
             break;
+        case 'g':
+            opt.grid = optarg;
+            break;
+        case 'n':
+            opt.necklaces = true;
+            break;
+        case 's':
+            opt.symbols = true;
+            break;
+        case 'S':
+            opt.sweep = true;
+            break;
+        case 'j':
+            if (auto const n{read_range(optarg)}; n && n->first == n->last && n->first > 0)
+                opt.n_threads = n->first;
+            else
+            {
+                std::cerr << "Bad number of threads: '" << optarg << "'\n" << usage
+                          << std::endl;
+                exit(1);
+            }
+            break;
         case 'h':
             std::cerr << info << std::endl;
             [[fallthrough]];
@@ -95,38 +191,175 @@ Options read_options(int argc, char** argv)
         }
     }
 
-    if (optind < argc) opt.n_rows = std::atoi(argv[optind++]);
-    if (optind < argc) opt.n_bricks = std::atoi(argv[optind++]);
-    if (optind < argc) opt.widest_brick = std::atoi(argv[optind++]);;
+    for (auto range : {&opt.rows, &opt.bricks, &opt.widest})
+    {
+        if (optind >= argc)
+            break;
+        auto const arg{argv[optind++]};
+        if (auto const r{read_range(arg)})
+            *range = *r;
+        else
+        {
+            std::cerr << "Bad number or range: '" << arg << "'\n" << usage << std::endl;
+            exit(1);
+        }
+        if (!opt.grid && range->first != range->last)
+        {
+            std::cerr << "Ranges are allowed only with --grid: '" << arg << "'\n"
+                      << usage << std::endl;
+            exit(1);
+        }
+    }
+    // Widths are stored in 8 bits and periods in 16.
+    if (opt.widest.last > max_brick_width
+        || std::int64_t{opt.bricks.last}*opt.widest.last > max_row_period)
+    {
+        std::cerr << "max_brick must be at most " << max_brick_width
+                  << " and bricks times max_brick at most " << max_row_period << ".\n"
+                  << usage << std::endl;
+        exit(1);
+    }
+    opt.n_rows = opt.rows.first;
+    opt.n_bricks = opt.bricks.first;
+    opt.widest_brick = opt.widest.first;
     return opt;
 }
 
+void write_grid(std::ostream& os, std::vector<GridCount> const& counts, bool json)
+{
+    if (json)
+    {
+        os << "[";
+        for (char const* sep{"\n"}; auto const& c : counts)
+        {
+            os << sep << "  {\"courses\": " << c.n_rows << ", \"bricks\": " << c.n_bricks
+               << ", \"max_brick\": " << c.widest_brick << ", \"walls\": " << c.count << "}";
+            sep = ",\n";
+        }
+        os << "\n]" << std::endl;
+        return;
+    }
+    os << "courses,bricks,max_brick,walls\n";
+    for (auto const& c : counts)
+        os << c.n_rows << ',' << c.n_bricks << ',' << c.widest_brick << ',' << c.count << '\n';
+}
+
+// @return The number of walls, and of orbits if they're canonical, calculated without
+// generating them.
+SymmetryCount count_walls(Options const& opt)
+{
+    if (opt.canonical)
+        return num_canonical_brickworks(opt.n_rows, opt.n_bricks, opt.widest_brick);
+    auto const n{num_brickworks(opt.n_rows, opt.n_bricks, opt.widest_brick, opt.n_threads)};
+    return {n, n};
+}
+
+// @return The same counts as count_walls() for walls that are about to be rendered. The
+// image must be sized before they're drawn. Except for the 2-course sieve, the counts come
+// from a pass of the search that draws them. The transfer matrix behind the other counts
+// would cost more than the search for the large catalogs that generate() backtracks
+// through.
+SymmetryCount count_rendered(Options const& opt)
+{
+    if (!opt.canonical && opt.n_rows == 2)
+        return count_walls(opt);
+    SymmetryCount count{0, 0};
+    if (opt.canonical)
+        generate_canonical(opt.n_rows, opt.n_bricks, opt.widest_brick,
+                           [&count](Orbit const& orbit) {
+                               ++count.canonical;
+                               count.raw += orbit.size;
+                           },
+                           opt.n_threads);
+    else
+        generate(opt.n_rows, opt.n_bricks, opt.widest_brick,
+                 [&count](Wall const&) { ++count.raw; }, opt.n_threads);
+    return count;
+}
+
 int main(int argc, char* argv[])
 {
     auto const opt{read_options(argc, argv)};
 
-    if (!opt.render && opt.n_rows == 2)
+    if (opt.necklaces)
     {
-        // Use the fast counting algorithm if 2 courses of 2 bricks.
-        std::cout << num_brickworks(opt.n_rows, opt.n_bricks, opt.widest_brick) << std::endl;
+        if (opt.render)
+        {
+            for (auto const& necklace : necklaces(opt.n_bricks, opt.widest_brick))
+            {
+                std::cout << necklace.multiplicity;
+                for (char sep{'\t'}; auto width : necklace.row.pattern())
+                {
+                    std::cout << sep << static_cast<int>(width);
+                    sep = ' ';
+                }
+                std::cout << '\n';
+            }
+            return 0;
+        }
+        if (opt.n_rows != 2)
+        {
+            std::cerr << "Canonical counts are only available for 2 courses." << std::endl;
+            return 1;
+        }
+        auto const count{count_necklace_pairs(opt.n_bricks, opt.widest_brick)};
+        std::cout << count.canonical << ' ' << count.raw << std::endl;
         return 0;
     }
-    auto walls{generate(opt.n_rows, opt.n_bricks, opt.widest_brick)};
-    std::cout << walls.size() << std::endl;
+
+    if (opt.grid)
+    {
+        if (*opt.grid != "csv" && *opt.grid != "json")
+        {
+            std::cerr << "The grid format must be 'csv' or 'json'." << std::endl;
+            return 1;
+        }
+        write_grid(std::cout, grid_num_brickworks(opt.rows, opt.bricks, opt.widest,
+                                                  opt.n_threads),
+                   *opt.grid == "json");
+        return 0;
+    }
+
+    if (opt.sweep)
+    {
+        auto const counts{sweep_num_brickworks(opt.n_rows, opt.n_bricks, opt.widest_brick,
+                                               opt.n_threads)};
+        for (auto widest{1}; widest < static_cast<int>(counts.size()); ++widest)
+            std::cout << widest << ' ' << counts[widest] << '\n';
+        return 0;
+    }
+
+    auto const count{opt.render ? count_rendered(opt) : count_walls(opt)};
+    if (opt.canonical)
+        std::cout << count.canonical << ' ' << count.raw << std::endl;
+    else
+        std::cout << count.raw << std::endl;
     if (!opt.render)
         return 0;
 
+    auto const n_walls{opt.canonical ? count.canonical : count.raw};
+
+    // Generate the walls on demand so they don't have to be stored.
+    WallSource const source{[&opt](WallVisitor const& visit) {
+        if (opt.canonical)
+            generate_canonical(opt.n_rows, opt.n_bricks, opt.widest_brick,
+                               [&visit](Orbit const& orbit) { visit(orbit.wall); },
+                               opt.n_threads);
+        else
+            generate(opt.n_rows, opt.n_bricks, opt.widest_brick, visit, opt.n_threads);
+    }};
     if (opt.ascii)
     {
         if (opt.output)
         {
             std::ofstream os{*opt.output};
-            ascii_walls(os, walls, 8);
+            ascii_walls(os, source, 8);
         }
         else
-            ascii_walls(std::cout, walls, 8);
+            ascii_walls(std::cout, source, 8);
     }
     else
-        svg_walls((opt.output ? *opt.output : "brickwork") + ".svg", 300, walls, 8);
+        svg_walls((opt.output ? *opt.output : "brickwork") + ".svg", 300, n_walls, source, 8,
+                  opt.symbols);
     return 0;
 }
@@ -0,0 +1,47 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "matrix.hh"
+
+Matrix Matrix::identity(std::size_t n)
+{
+    Matrix out(n);
+    for (std::size_t i{0}; i < n; ++i)
+        out(i, i) = 1;
+    return out;
+}
+
+Matrix Matrix::operator*(Matrix const& m) const
+{
+    Matrix out(m_n);
+    // Loop in i-k-j order for sequential access to both matrices.
+    for (std::size_t i{0}; i < m_n; ++i)
+        for (std::size_t k{0}; k < m_n; ++k)
+            if (auto const a{(*this)(i, k)}; a != 0)
+                for (std::size_t j{0}; j < m_n; ++j)
+                    out(i, j) += a*m(k, j);
+    return out;
+}
+
+Matrix power(Matrix const& m, int n)
+{
+    if (n == 0)
+        return Matrix::identity(m.size());
+    if (n == 1)
+        return m;
+    auto const half{power(m, n/2)};
+    auto const square{half*half};
+    return n % 2 == 0 ? square : square*m;
+}
@@ -0,0 +1,45 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MATRIX_HH
+#define MATRIX_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// A square matrix of counts. Arithmetic wraps modulo 2^64.
+class Matrix
+{
+public:
+    /// Construct an n by n matrix of zeros.
+    explicit Matrix(std::size_t n) : m_n{n}, m_v(n*n, 0) {}
+    /// @return The n by n identity matrix.
+    static Matrix identity(std::size_t n);
+
+    std::size_t size() const { return m_n; }
+    std::uint64_t& operator()(std::size_t i, std::size_t j) { return m_v[i*m_n + j]; }
+    std::uint64_t operator()(std::size_t i, std::size_t j) const { return m_v[i*m_n + j]; }
+    Matrix operator*(Matrix const& m) const;
+
+private:
+    std::size_t m_n;
+    std::vector<std::uint64_t> m_v;
+};
+
+/// @return The matrix to the power of n >= 0.
+Matrix power(Matrix const& m, int n);
+
+#endif // MATRIX_HH
@@ -0,0 +1,90 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "necklace.hh"
+#include "period_table.hh"
+
+namespace
+{
+// Generate the Lyndon words whose lengths divide the length of a[1..n] using the
+// Fredricksen-Kessler-Maiorana algorithm. a[0] is a sentinel. Letters are from 0 to k - 1.
+void fkm(std::vector<int>& a, int t, int p, int k, std::vector<Necklace>& out)
+{
+    auto const n{static_cast<int>(a.size()) - 1};
+    if (t > n)
+    {
+        // a[1..n] is a necklace. Its first p letters are its primitive part.
+        if (n % p == 0)
+        {
+            std::vector<int> widths(a.begin() + 1, a.begin() + 1 + p);
+            for (auto& w : widths)
+                ++w;
+            out.push_back({Row{0, widths}, p});
+        }
+        return;
+    }
+    a[t] = a[t - p];
+    fkm(a, t + 1, p, k, out);
+    for (auto j{a[t - p] + 1}; j < k; ++j)
+    {
+        a[t] = j;
+        fkm(a, t + 1, t, k, out);
+    }
+}
+}
+
+std::vector<Necklace> necklaces(int n_bricks, int widest_brick)
+{
+    std::vector<Necklace> out;
+    if (n_bricks < 1 || widest_brick < 1)
+        return out;
+    std::vector<int> a(n_bricks + 1, 0);
+    fkm(a, 1, 1, widest_brick, out);
+    return out;
+}
+
+NecklaceCount count_necklace_pairs(int n_bricks, int widest_brick)
+{
+    NecklaceCount count{0, 0};
+    if (n_bricks < 1 || widest_brick < 2)
+        return count;
+
+    auto const canonical{necklaces(n_bricks, widest_brick)};
+    PeriodTable const table(n_bricks*widest_brick);
+    std::vector<std::int64_t> correlation;
+    for (auto const& lower : canonical)
+        for (auto const& upper : canonical)
+        {
+            // Rotating the lower pattern to start at brick k shifts its perpends by -x_k.
+            // Likewise for the upper pattern and y_l. The rotated rows line up iff
+            // 1 + y_j - y_l = x_i - x_k for some i and j (mod the gcd of the periods).
+            // With delta = x_k - y_l, that's when delta + 1 is some x_i - y_j. So
+            // count the (k, l) pairs at each delta and keep the deltas where delta + 1
+            // doesn't occur.
+            auto const d{table.gcd(lower.row.period(), upper.row.period())};
+            correlation.assign(d, 0);
+            for (auto x : lower.row.perpends())
+                for (auto y : upper.row.perpends())
+                    ++correlation[((x - y) % d + d) % d];
+            std::int64_t fits{0};
+            for (auto delta{0}; delta < d; ++delta)
+                if (correlation[(delta + 1) % d] == 0)
+                    fits += correlation[delta];
+            count.raw += fits;
+            if (fits > 0)
+                ++count.canonical;
+        }
+    return count;
+}
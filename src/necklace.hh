@@ -0,0 +1,59 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef NECKLACE_HH
+#define NECKLACE_HH
+
+#include "wall.hh"
+
+#include <cstdint>
+#include <vector>
+
+/// A canonical row pattern. A raw pattern of n bricks is some rotation of a primitive
+/// pattern repeated to length n. {2,2} is {2} repeated, and {1,2,1} is a rotation of
+/// {1,1,2}. The canonical pattern is the smallest rotation of the primitive pattern, a
+/// Lyndon word.
+struct Necklace
+{
+    /// A row with the canonical pattern and an offset of 0.
+    Row row;
+    /// The number of raw patterns of n bricks that reduce to this one. Equal to the
+    /// length of the canonical pattern since the rotations of a primitive pattern are
+    /// distinct.
+    int multiplicity;
+};
+
+/// @return The canonical patterns for all raw patterns of n_bricks from 1 to
+/// widest_brick units wide, in lexicographic order. Generated directly, with the
+/// Fredricksen-Kessler-Maiorana algorithm, so the raw patterns are not enumerated. The
+/// multiplicities sum to widest_brick^n_bricks.
+std::vector<Necklace> necklaces(int n_bricks, int widest_brick);
+
+/// Two-course wall counts found by searching pairs of canonical patterns.
+struct NecklaceCount
+{
+    /// The number of pairs of canonical patterns for which some rotations fit together.
+    std::int64_t canonical;
+    /// The number of pairs of raw patterns that fit. The same as num_brickworks(2, ...).
+    std::int64_t raw;
+};
+
+/// @return The number of two-course walls of n_bricks from 1 to widest_brick units wide,
+/// counted over pairs of canonical patterns. Rotating a course changes how it fits
+/// against a course with a fixed lap, so the raw count is recovered by counting the
+/// fitting rotations of each canonical pair.
+NecklaceCount count_necklace_pairs(int n_bricks, int widest_brick);
+
+#endif // NECKLACE_HH
@@ -0,0 +1,45 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PARALLEL_HH
+#define PARALLEL_HH
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/// Call f(shard) for each shard from 0 to n_shards - 1 on up to n_threads threads. Shards
+/// are handed out in increasing order as threads become free. If n_threads is less than
+/// 2, the shards are processed in order on the calling thread.
+template <typename F> void for_each_shard(int n_shards, int n_threads, F const& f)
+{
+    if (n_threads < 2 || n_shards < 2)
+    {
+        for (auto shard{0}; shard < n_shards; ++shard)
+            f(shard);
+        return;
+    }
+    std::atomic<int> next{0};
+    std::vector<std::jthread> threads;
+    for (auto i{std::min(n_threads, n_shards)}; i > 0; --i)
+        threads.emplace_back([&] {
+            for (auto shard{next++}; shard < n_shards; shard = next++)
+                f(shard);
+        });
+    // The jthreads join when they go out of scope.
+}
+
+#endif // PARALLEL_HH
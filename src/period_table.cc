@@ -0,0 +1,46 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "period_table.hh"
+
+#include <algorithm>
+#include <limits>
+
+PeriodTable::PeriodTable(int max_period)
+    : m_max_period{max_period}
+{
+    assert(max_period >= 0 && max_period <= std::numeric_limits<std::uint16_t>::max());
+    auto const n{static_cast<std::size_t>(max_period) + 1};
+    if (max_period <= max_dense_period)
+    {
+        m_gcd.resize(n*n);
+        // Fill by Euclid's recurrence so each entry takes one lookup. The entry it refers
+        // to is in an earlier row or earlier in the same row.
+        for (std::size_t x{0}; x < n; ++x)
+            for (std::size_t y{0}; y < n; ++y)
+            {
+                auto& entry{m_gcd[x*n + y]};
+                if (x == 0 || y == 0)
+                    entry = static_cast<std::uint16_t>(x + y);
+                else if (x >= y)
+                    entry = m_gcd[y*n + x % y];
+                else
+                    entry = m_gcd[x*n + y % x];
+            }
+    }
+    m_divisors.reserve(n);
+    for (auto d{0}; d <= max_period; ++d)
+        m_divisors.emplace_back(std::max(d, 1));
+}
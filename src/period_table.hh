@@ -0,0 +1,101 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PERIOD_TABLE_HH
+#define PERIOD_TABLE_HH
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+/// Division by a fixed divisor with a multiplication and a shift instead of a division
+/// instruction. Exact for dividends and divisors with magnitudes less than 2^21.
+class Divisor
+{
+public:
+    /// The largest magnitude of a dividend or divisor, exclusive.
+    static int constexpr limit{1 << 21};
+
+    explicit Divisor(int d = 1)
+        : m_d{d},
+          m_reciprocal{(std::uint64_t{1} << shift)/static_cast<std::uint64_t>(d) + 1}
+    {
+        assert(d > 0 && d < limit);
+    }
+
+    /// @return The divisor.
+    int value() const { return m_d; }
+    /// @return v modulo the divisor in [0, d).
+    int residue(int v) const
+    {
+        // -1 - v is non-negative, and v = -1 - (-1 - v).
+        return v >= 0 ? reduce(v) : m_d - 1 - reduce(-1 - v);
+    }
+    /// @return True if the divisor divides v.
+    bool divides(int v) const { return residue(v) == 0; }
+
+private:
+    // With M = floor(2^k/d) + 1, the error M*d - 2^k is at most d, so floor(v*M/2^k) is
+    // floor(v/d) as long as v*d < 2^k.
+    static int constexpr shift{42};
+
+    int reduce(int v) const
+    {
+        auto const q{static_cast<int>((static_cast<std::uint64_t>(v)*m_reciprocal) >> shift)};
+        return v - q*m_d;
+    }
+
+    int m_d;
+    std::uint64_t m_reciprocal;
+};
+
+/// The gcds and lcms of all pairs of periods up to a maximum, and a Divisor for each
+/// possible gcd. Build one for a search and share it between the checks.
+class PeriodTable
+{
+public:
+    /// The largest max_period for which the gcds are tabulated. The table has
+    /// (max_period + 1)^2 entries, so above this they're computed instead.
+    static int constexpr max_dense_period{2048};
+
+    /// Fill the tables for periods from 1 to max_period, which must be at most 65535.
+    explicit PeriodTable(int max_period);
+
+    int max_period() const { return m_max_period; }
+    /// @return The gcd of two periods from 1 to max_period().
+    int gcd(int x, int y) const
+    {
+        return m_gcd.empty() ? std::gcd(x, y)
+                             : m_gcd[static_cast<std::size_t>(x)*(m_max_period + 1) + y];
+    }
+    /// @return The lcm of two periods from 1 to max_period().
+    std::int64_t lcm(int x, int y) const { return std::int64_t{x}/gcd(x, y)*y; }
+    /// @return The reciprocal constants for a divisor from 1 to max_period().
+    Divisor const& divisor(int d) const { return m_divisors[d]; }
+    /// @return The divisor for the gcd of two periods.
+    Divisor const& gcd_divisor(int x, int y) const { return m_divisors[gcd(x, y)]; }
+
+private:
+    int m_max_period;
+    /// The gcds indexed by x*(max_period + 1) + y, or empty if max_period is greater
+    /// than max_dense_period.
+    std::vector<std::uint16_t> m_gcd;
+    /// The divisors indexed by value. Index 0 is unused.
+    std::vector<Divisor> m_divisors;
+};
+
+#endif // PERIOD_TABLE_HH
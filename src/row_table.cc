@@ -0,0 +1,49 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "row_table.hh"
+#include "hash.hh"
+
+#include <cassert>
+#include <limits>
+
+std::size_t RowHash::operator()(Row const& row) const
+{
+    // The pattern determines the period and perpends, so they're left out.
+    Fnv1a hash;
+    hash.add(static_cast<std::uint64_t>(row.offset()));
+    for (auto width : row.pattern())
+        hash.add(width);
+    return hash.value();
+}
+
+RowId RowTable::intern(Row const& row)
+{
+    auto const [it, added]{m_ids.try_emplace(row, static_cast<RowId>(m_rows.size()))};
+    if (added)
+    {
+        assert(m_rows.size() < std::numeric_limits<RowId>::max());
+        m_rows.push_back(row);
+    }
+    return it->second;
+}
+
+std::optional<RowId> RowTable::find(Row const& row) const
+{
+    auto const it{m_ids.find(row)};
+    if (it == m_ids.end())
+        return std::nullopt;
+    return it->second;
+}
@@ -0,0 +1,55 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ROW_TABLE_HH
+#define ROW_TABLE_HH
+
+#include "wall.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+/// A dense identifier for a distinct row.
+using RowId = std::uint32_t;
+
+/// A hash of a row's offset and pattern.
+struct RowHash
+{
+    std::size_t operator()(Row const& row) const;
+};
+
+/// Gives each distinct row a dense ID in the order the rows are first seen. Data that
+/// depends only on the row can be kept in a vector indexed by ID and worked out once.
+class RowTable
+{
+public:
+    /// @return The ID of the row. The row is added with the next ID if it's new.
+    RowId intern(Row const& row);
+    /// @return The ID of the row, or nothing if it hasn't been added.
+    std::optional<RowId> find(Row const& row) const;
+    /// @return The row with the ID.
+    Row const& operator[](RowId id) const { return m_rows[id]; }
+    /// @return The number of distinct rows.
+    std::size_t size() const { return m_rows.size(); }
+
+private:
+    std::vector<Row> m_rows;
+    std::unordered_map<Row, RowId, RowHash> m_ids;
+};
+
+#endif // ROW_TABLE_HH
@@ -0,0 +1,205 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SMALL_VECTOR_HH
+#define SMALL_VECTOR_HH
+
+#include <algorithm>
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+/// A sequence that stores up to N elements inline so that copying it does not allocate.
+/// Longer sequences go in memory from the allocator, the heap by default. The inline
+/// elements share space with the pointer to the long storage, so the sequence is no
+/// bigger than a pointer, a capacity, a memory resource and a size.
+template <typename T, std::size_t N> class SmallVector
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+    using value_type = T;
+    using allocator_type = std::pmr::polymorphic_allocator<T>;
+    /// The number of elements stored inline.
+    static std::size_t constexpr inline_size{N};
+
+    SmallVector() = default;
+    explicit SmallVector(allocator_type alloc) : m_resource{alloc.resource()} {}
+    /// Copy a sequence. Long sequences use the default resource.
+    SmallVector(SmallVector const& v) : SmallVector(v, allocator_type{}) {}
+    /// Move a sequence, taking over its storage if it's long. The source is left empty.
+    SmallVector(SmallVector&& v) noexcept
+        : m_resource{v.m_resource}
+    {
+        take(v);
+    }
+    /// Copy a sequence using the allocator if it's long.
+    SmallVector(SmallVector const& v, allocator_type alloc)
+        : m_resource{alloc.resource()}
+    {
+        assign(v.begin(), v.size());
+    }
+    /// Move a sequence using the allocator if it's long. The storage is taken over if it
+    /// came from an equal allocator. The source is left empty.
+    SmallVector(SmallVector&& v, allocator_type alloc)
+        : m_resource{alloc.resource()}
+    {
+        move_from(v);
+    }
+    /// Construct from a range of values.
+    template <std::input_iterator It>
+    SmallVector(It first, It last, allocator_type alloc = {})
+        : m_resource{alloc.resource()}
+    {
+        for (; first != last; ++first)
+            push_back(static_cast<T>(*first));
+    }
+    ~SmallVector() { clear(); }
+
+    /// Assignment keeps this sequence's allocator.
+    SmallVector& operator=(SmallVector const& v)
+    {
+        if (this != &v)
+        {
+            clear();
+            assign(v.begin(), v.size());
+        }
+        return *this;
+    }
+    SmallVector& operator=(SmallVector&& v)
+    {
+        if (this != &v)
+        {
+            clear();
+            move_from(v);
+        }
+        return *this;
+    }
+
+    /// Add a value to the end.
+    void push_back(T x);
+    /// Remove all of the elements and free any long storage.
+    void clear();
+
+    /// @return The number of elements.
+    std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    T operator[](std::size_t i) const { return data()[i]; }
+    T const* begin() const { return data(); }
+    T const* end() const { return data() + m_size; }
+
+    /// Compare lexicographically.
+    auto operator<=>(SmallVector const& v) const
+    {
+        return std::lexicographical_compare_three_way(begin(), end(), v.begin(), v.end());
+    }
+    bool operator==(SmallVector const& v) const
+    {
+        return std::equal(begin(), end(), v.begin(), v.end());
+    }
+
+private:
+    bool is_long() const { return m_size > N; }
+    T const* data() const { return is_long() ? m_storage.heap.data : m_storage.values.data(); }
+    /// Copy n values into this empty sequence.
+    void assign(T const* values, std::size_t n);
+    /// Take the elements of v, which must use an equal resource if it's long.
+    void take(SmallVector& v)
+    {
+        m_storage = v.m_storage;
+        m_size = std::exchange(v.m_size, 0);
+        v.m_storage.values = {};
+    }
+    /// Take or copy the elements of v into this empty sequence.
+    void move_from(SmallVector& v)
+    {
+        if (!v.is_long() || v.m_resource->is_equal(*m_resource))
+            take(v);
+        else
+        {
+            assign(v.begin(), v.size());
+            v.clear();
+        }
+    }
+
+    struct Heap
+    {
+        T* data;
+        std::size_t capacity;
+    };
+    /// The resource for long sequences.
+    std::pmr::memory_resource* m_resource{std::pmr::get_default_resource()};
+    /// The elements of a short sequence, or the storage for a long one.
+    union Storage
+    {
+        std::array<T, N> values{};
+        Heap heap;
+    } m_storage;
+    std::uint32_t m_size{0};
+};
+
+template <typename T, std::size_t N> void SmallVector<T, N>::push_back(T x)
+{
+    if (m_size < N)
+        m_storage.values[m_size] = x;
+    else
+    {
+        // Move to new storage when the inline elements or the long storage are full.
+        auto const capacity{is_long() ? m_storage.heap.capacity : N};
+        if (m_size == capacity)
+        {
+            auto* const grown{static_cast<T*>(
+                    m_resource->allocate(2*capacity*sizeof(T), alignof(T)))};
+            std::copy(begin(), end(), grown);
+            if (is_long())
+                m_resource->deallocate(m_storage.heap.data, capacity*sizeof(T), alignof(T));
+            m_storage.heap = {grown, 2*capacity};
+        }
+        m_storage.heap.data[m_size] = x;
+    }
+    ++m_size;
+}
+
+template <typename T, std::size_t N> void SmallVector<T, N>::clear()
+{
+    if (is_long())
+    {
+        m_resource->deallocate(m_storage.heap.data, m_storage.heap.capacity*sizeof(T),
+                               alignof(T));
+        m_storage.values = {};
+    }
+    m_size = 0;
+}
+
+template <typename T, std::size_t N>
+void SmallVector<T, N>::assign(T const* values, std::size_t n)
+{
+    if (n > N)
+    {
+        auto* const data{static_cast<T*>(m_resource->allocate(n*sizeof(T), alignof(T)))};
+        std::copy(values, values + n, data);
+        m_storage.heap = {data, n};
+    }
+    else
+        std::copy(values, values + n, m_storage.values.begin());
+    m_size = static_cast<std::uint32_t>(n);
+}
+
+#endif // SMALL_VECTOR_HH
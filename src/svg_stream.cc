@@ -0,0 +1,77 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "svg_stream.hh"
+
+auto constexpr buffer_size{1 << 20};
+
+SvgStream::SvgStream(std::string const& file, svg::Layout const& layout, bool symbols)
+    : m_layout{layout},
+      m_buffer(buffer_size)
+{
+    // The buffer must be set before the file is opened.
+    m_os.rdbuf()->pubsetbuf(m_buffer.data(), m_buffer.size());
+    m_os.open(file);
+    // Match svg::Document's header. With symbols, also declare the namespace of use()'s
+    // references.
+    m_os << "<?xml " << svg::attribute("version", "1.0") << svg::attribute("standalone", "no")
+         << "?>\n<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" "
+         << "\"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n<svg "
+         << svg::attribute("width", layout.dimensions.width, "px")
+         << svg::attribute("height", layout.dimensions.height, "px")
+         << svg::attribute("xmlns", "http://www.w3.org/2000/svg");
+    if (symbols)
+        m_os << svg::attribute("xmlns:xlink", "http://www.w3.org/1999/xlink");
+    m_os << svg::attribute("version", "1.1") << ">\n";
+}
+
+SvgStream::~SvgStream()
+{
+    close();
+}
+
+SvgStream& SvgStream::operator<<(svg::Shape const& shape)
+{
+    m_os << shape.toString(m_layout);
+    return *this;
+}
+
+void SvgStream::begin_symbol(std::string const& id)
+{
+    // Each symbol gets its own defs block so symbols can be defined as they're needed.
+    m_os << svg::elemStart("defs") << ">\n"
+         << svg::elemStart("symbol") << svg::attribute("id", id)
+         << svg::attribute("overflow", "visible") << ">\n";
+}
+
+void SvgStream::end_symbol()
+{
+    m_os << svg::elemEnd("symbol") << svg::elemEnd("defs");
+}
+
+void SvgStream::use(std::string const& id, double x, double y)
+{
+    m_os << svg::elemStart("use") << svg::attribute("xlink:href", "#" + id)
+         << svg::attribute("x", svg::translateX(x, m_layout))
+         << svg::attribute("y", svg::translateY(y, m_layout)) << svg::emptyElemEnd();
+}
+
+void SvgStream::close()
+{
+    if (!m_os.is_open())
+        return;
+    m_os << svg::elemEnd("svg");
+    m_os.close();
+}
@@ -0,0 +1,56 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SVG_STREAM_HH
+#define SVG_STREAM_HH
+
+#include "simple_svg_1.0.0.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+/// An SVG document that writes each shape to the file as it's added instead of holding
+/// the shapes until it's saved. Without symbols, the output is the same as
+/// svg::Document's, but memory use does not depend on the number of shapes.
+class SvgStream
+{
+public:
+    /// Open the file and write the header. If symbols is true, the header declares the
+    /// namespace that use() needs.
+    SvgStream(std::string const& file, svg::Layout const& layout, bool symbols = false);
+    /// Close the document if close() has not been called.
+    ~SvgStream();
+
+    /// Write a shape to the file.
+    SvgStream& operator<<(svg::Shape const& shape);
+    /// Start the definition of a symbol that can be placed with use(). Shapes written
+    /// before the call to end_symbol() are part of the symbol and are not drawn.
+    void begin_symbol(std::string const& id);
+    void end_symbol();
+    /// Place a copy of a symbol with its origin at (x, y). The stream must have been
+    /// opened with symbols.
+    void use(std::string const& id, double x, double y);
+    /// Write the closing tag and close the file.
+    void close();
+
+private:
+    svg::Layout m_layout;
+    /// The output buffer. Larger than the default to reduce the number of writes.
+    std::vector<char> m_buffer;
+    std::ofstream m_os;
+};
+
+#endif // SVG_STREAM_HH
@@ -17,9 +17,33 @@
 #include "doctest.h"
 
 #include "brickwork.hh"
+#include "catalog.hh"
+#include "compat_matrix.hh"
+#include "counter.hh"
+#include "draw.hh"
+#include "kernels.hh"
+#include "necklace.hh"
+#include "period_table.hh"
+#include "row_table.hh"
+#include "wall_store.hh"
 #include "wall.hh"
 
+#include "simple_svg_1.0.0.hpp"
+
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory_resource>
+#include <numeric>
+#include <regex>
+#include <set>
+#include <string>
 
 bool test_is_brickwork(Row const& r1, Row const& r2)
 {
@@ -36,6 +60,33 @@ bool test_is_brickwork(Row const& r1, Row const& r2)
     return true;
 }
 
+// The original implementation of is_brickwork(). Walk both rows until the gaps line up
+// or the pattern repeats. The cost is proportional to the LCM of the periods.
+bool leapfrog_is_brickwork(Row const& lower, Row const& upper)
+{
+    if (lower.period() <= 0 || upper.period() <= 0)
+        return false;
+
+    auto const n_to_check{std::lcm(lower.period(), upper.period())};
+    auto const b1{lower.offset()};
+    auto const b2{upper.offset()};
+
+    auto const& p1{lower.pattern()};
+    auto const& p2{upper.pattern()};
+    auto x1{b1};
+    auto x2{b2};
+    auto i1{0u};
+    auto i2{0u};
+    while (x1 != x2 && (x1 < b1 + n_to_check || x2 < b2 + n_to_check))
+    {
+        while (x1 < x2)
+            x1 += p1[i1++ % p1.size()];
+        while (x2 < x1)
+            x2 += p2[i2++ % p2.size()];
+    }
+    return x1 != x2;
+}
+
 void CHECK_BW(Wall const& wall, bool is = true)
 {
     for (std::size_t i{0}; i < wall.size(); ++i)
@@ -45,6 +96,7 @@ void CHECK_BW(Wall const& wall, bool is = true)
         auto test_bw = test_is_brickwork(r1, r2);
         auto bw = is_brickwork(r1, r2);
         CHECK(test_bw == bw);
+        CHECK(leapfrog_is_brickwork(r1, r2) == bw);
         CHECK(test_bw == is);
         if (test_bw != bw || test_bw != is)
         {
@@ -54,6 +106,143 @@ void CHECK_BW(Wall const& wall, bool is = true)
     }
 }
 
+// The original SVG rendering, which held the whole document in an svg::Document until it
+// was saved. svg_walls() without symbols must write the same bytes.
+void document_walls(std::string const& file, int width, std::vector<Wall> const& walls,
+                    int n_courses)
+{
+    auto constexpr height_unit{9};
+    auto constexpr length_unit{10};
+    auto constexpr gap{1};
+    auto constexpr row_height{height_unit + gap};
+    auto const brick{[](svg::Document& doc, int x, int y, int length, svg::Color color) {
+        doc << svg::Rectangle(svg::Point(x, y), length*length_unit - gap, height_unit, color);
+    }};
+    auto const total_rows{walls.empty() ? 0 : (n_courses + 1)*walls.size() - 1};
+    auto const height{static_cast<int>(total_rows*row_height)};
+    svg::Document doc(file, svg::Layout(svg::Dimensions(width, height),
+                                        svg::Layout::TopLeft));
+    doc << svg::Rectangle(svg::Point(0, 0), width + 1, height + 1, svg::Color(128, 128, 128));
+    for (int y{0}; auto const& wall : walls)
+    {
+        for (auto i{n_courses}; i-- > 0; y += row_height)
+        {
+            auto const& row{wall[i % wall.size()]};
+            auto x{0};
+            if (row.offset() != 0)
+            {
+                brick(doc, x, y, row.offset(), svg::Color(80, 80, 80));
+                x += row.offset()*length_unit;
+            }
+            while (x < width + 1)
+                for (auto p : row.pattern())
+                {
+                    brick(doc, x, y, p, svg::Color(170 - 20*p, 50, 30));
+                    x += p*length_unit;
+                }
+        }
+        y += row_height;
+    }
+    doc.save();
+}
+
+// @return The contents of the file, which is then removed.
+std::string take_file(std::filesystem::path const& file)
+{
+    std::ifstream is{file};
+    std::string const out{std::istreambuf_iterator<char>(is), {}};
+    is.close();
+    std::filesystem::remove(file);
+    return out;
+}
+
+TEST_CASE("counter")
+{
+    Counter counter(4, 1, 3);
+    CHECK(counter.total() == 81);
+    for (std::uint64_t i{0}; !counter.overflow(); ++i, ++counter)
+    {
+        CHECK(counter.rank() == i);
+        Counter unranked(4, 1, 3, i);
+        CHECK(std::equal(counter.begin(), counter.end(), unranked.begin()));
+        CHECK(counter.sum() == unranked.sum());
+        CHECK(!unranked.overflow());
+        for (std::uint64_t k : {0, 1, 5, 40})
+        {
+            auto stepped{counter};
+            for (auto j{k}; j > 0; --j)
+                ++stepped;
+            auto advanced{counter};
+            advanced += k;
+            CHECK(std::equal(stepped.begin(), stepped.end(), advanced.begin()));
+            CHECK(stepped.sum() == advanced.sum());
+            CHECK(stepped.overflow() == advanced.overflow());
+        }
+    }
+    CHECK(counter.rank() == 0);
+    CHECK(Counter(4, 1, 3, 81).overflow());
+}
+
+TEST_CASE("pattern storage")
+{
+    // The inline elements overlap the long storage instead of sitting beside a vector.
+    CHECK(sizeof(Pattern) <= sizeof(std::pmr::vector<std::uint8_t>));
+    // The widest brick isn't truncated.
+    Row const wide{0, {max_brick_width, 1}};
+    CHECK(wide.pattern()[0] == max_brick_width);
+    CHECK(wide.period() == max_brick_width + 1);
+    std::vector<int> lengths;
+    for (auto i{1}; i <= 40; ++i)
+    {
+        lengths.push_back(i % 7 + 1);
+        Row const row{i % 2, lengths};
+        auto const copy{row};
+        CHECK(copy == row);
+        CHECK(row.pattern().size() == lengths.size());
+        CHECK(std::equal(row.pattern().begin(), row.pattern().end(), lengths.begin()));
+        // Compare patterns on either side of the inline limit.
+        Row const prefix{i % 2, lengths.begin(), lengths.end() - 1};
+        CHECK(prefix < row);
+        CHECK(is_brickwork(row, Row{1, {3, 2}})
+              == leapfrog_is_brickwork(row, Row{1, {3, 2}}));
+    }
+}
+
+TEST_CASE("moved-from rows")
+{
+    std::vector<int> const lengths(20, 1);
+    for (auto n : {3, 20})
+    {
+        Row source{0, lengths.begin(), lengths.begin() + n};
+        Row const moved{std::move(source)};
+        CHECK(moved == Row(0, lengths.begin(), lengths.begin() + n));
+        // The source is empty, not a long size with no storage.
+        CHECK(source.pattern().empty());
+        CHECK(source.pattern().begin() == source.pattern().end());
+        CHECK(source.period() == 0);
+        CHECK(source.perpends().empty());
+
+        Row assigned{1, {2}};
+        Row other{0, lengths.begin(), lengths.begin() + n};
+        assigned = std::move(other);
+        CHECK(assigned == moved);
+        CHECK(other.pattern().empty());
+        CHECK(other.period() == 0);
+        CHECK(other.perpends().empty());
+    }
+}
+
+TEST_CASE("period and perpends")
+{
+    Row const row{1, {3, 1, 2}};
+    CHECK(row.period() == 6);
+    std::vector const perpends{0, 3, 4};
+    CHECK(std::equal(row.perpends().begin(), row.perpends().end(), perpends.begin(),
+                     perpends.end()));
+    CHECK(Row(0, {}).period() == 0);
+    CHECK(Row(0, {}).perpends().empty());
+}
+
 TEST_CASE("empty rows")
 {
     Row row1(0, {});
@@ -108,6 +297,389 @@ TEST_CASE("flemish bond")
     CHECK_BW({Row{0, {3,1}}, Row{1, {1,3}}});
 }
 
+TEST_CASE("long periods")
+{
+    // Periods too long for the 80-character string comparison. Check against the
+    // leapfrog walk.
+    auto const low{1};
+    auto const high{6};
+    for (auto i{low}; i <= high; ++i)
+        for (auto j{low}; j <= high; ++j)
+            for (auto k{low}; k <= high; ++k)
+                for (auto b{0}; b < 3; ++b)
+                {
+                    Row lower{b, {41*i, 13*j, k}};
+                    Row upper{1, {37*k, 7*i, j, 2}};
+                    CHECK(is_brickwork(lower, upper) == leapfrog_is_brickwork(lower, upper));
+                    CHECK(is_brickwork(upper, lower) == leapfrog_is_brickwork(upper, lower));
+                }
+}
+
+// The original implementation of generate(). Run a counter over the widths of all of the
+// bricks in all of the courses.
+std::vector<Wall> odometer_generate(int n_rows, int n_bricks, int widest_brick)
+{
+    std::vector<Wall> walls;
+    if (n_rows < 2 || n_bricks < 1 || widest_brick < 2)
+        return walls;
+
+    for (Counter widths(n_rows*n_bricks, 1, widest_brick); !widths.overflow(); ++widths)
+    {
+        Wall wall{Row{0, std::vector(widths.rbegin(), widths.rbegin() + n_bricks)}};
+        for (auto row_num{1}; row_num < n_rows; ++row_num)
+        {
+            Row row{row_num % 2,
+                std::vector(widths.rbegin() + row_num*n_bricks,
+                            widths.rbegin() + (row_num + 1)*n_bricks)};
+            if (is_brickwork(row, wall.back()))
+            {
+                wall.push_back(row);
+                if (static_cast<int>(wall.size()) == n_rows)
+                    break;
+            }
+        }
+        if (static_cast<int>(wall.size()) == n_rows
+            && is_brickwork(wall.front(), wall.back()))
+            walls.push_back(wall);
+    }
+    return walls;
+}
+
+TEST_CASE("generate matches odometer")
+{
+    for (auto n_rows : {1, 2, 3, 4, 6})
+        for (auto n_bricks : {1, 2, 3})
+            for (auto widest : {1, 2, 3, 4})
+                if (std::pow(widest, n_rows*n_bricks) <= 1 << 16)
+                    CHECK(generate(n_rows, n_bricks, widest)
+                          == odometer_generate(n_rows, n_bricks, widest));
+}
+
+TEST_CASE("backtrack")
+{
+    for (auto n_rows : {1, 2, 4, 6})
+        for (auto n_bricks : {1, 2, 3})
+            for (auto widest : {1, 2, 3, 4})
+                if (std::pow(widest, n_bricks) <= 30)
+                {
+                    for (auto n_threads : {1, 3})
+                    {
+                        std::vector<Wall> walls;
+                        backtrack(n_rows, n_bricks, widest,
+                                  [&walls](Wall const& wall) { walls.push_back(wall); },
+                                  n_threads);
+                        CHECK(walls == generate(n_rows, n_bricks, widest));
+                    }
+                }
+}
+
+TEST_CASE("row table")
+{
+    RowTable table;
+    CHECK(table.intern(Row(0, {1, 2})) == 0);
+    CHECK(table.intern(Row(1, {1, 2})) == 1);
+    CHECK(table.intern(Row(0, {2, 1})) == 2);
+    CHECK(table.intern(Row(0, {1, 2})) == 0);
+    CHECK(table.size() == 3);
+    CHECK(table[1] == Row(1, {1, 2}));
+    CHECK(table.find(Row(0, {2, 1})) == 2);
+    CHECK(!table.find(Row(1, {2, 1})));
+}
+
+TEST_CASE("wall store")
+{
+    SUBCASE("generated walls")
+    {
+        auto const walls{generate(4, 3, 5)};
+        WallStore store(4, 3, 5);
+        for (auto const& wall : walls)
+            store.push_back(wall);
+        REQUIRE(store.size() == walls.size());
+        // 4 courses of 3 bricks of 3 bits fit in one word.
+        CHECK(store.bytes() == walls.size()*8);
+        for (std::size_t i{0}; i < walls.size(); i += 97)
+        {
+            CHECK(store[i] == walls[i]);
+            CHECK(store.row(i, 3) == walls[i][3]);
+        }
+        // generate() visits walls in order.
+        store.sort();
+        for (std::size_t i{0}; i < walls.size(); i += 97)
+            CHECK(store[i] == walls[i]);
+        std::vector<Wall> visited;
+        store.visit([&visited](Wall const& wall) { visited.push_back(wall); });
+        CHECK(visited == walls);
+    }
+    SUBCASE("keys split across words")
+    {
+        // 6 courses of 4 bricks of 3 bits take 72 bits. Any rows can be stored.
+        auto const even{make_rows(0, 4, 5)};
+        auto const odd{make_rows(1, 4, 5)};
+        std::vector<Wall> walls;
+        for (std::size_t i{0}; i < 200; ++i)
+        {
+            Wall wall;
+            for (std::size_t course{0}; course < 6; ++course)
+            {
+                auto const& rows{course % 2 == 0 ? even : odd};
+                wall.push_back(rows[(i*i*7 + course*13) % rows.size()]);
+            }
+            walls.push_back(wall);
+        }
+        WallStore store(6, 4, 5);
+        // Add each wall twice in reverse order.
+        for (auto it{walls.rbegin()}; it != walls.rend(); ++it)
+        {
+            store.push_back(*it);
+            store.push_back(*it);
+        }
+        CHECK(store.key(0).size() == 2);
+        CHECK(store[0] == walls.back());
+        CHECK(store.hash(0) == store.hash(1));
+        CHECK(store.hash(0) != store.hash(2));
+
+        std::sort(walls.begin(), walls.end());
+        walls.erase(std::unique(walls.begin(), walls.end()), walls.end());
+        store.dedupe();
+        REQUIRE(store.size() == walls.size());
+        for (std::size_t i{0}; i < walls.size(); ++i)
+            CHECK(store[i] == walls[i]);
+    }
+}
+
+TEST_CASE("period table")
+{
+    PeriodTable const table(60);
+    CHECK(table.max_period() == 60);
+    for (auto x{1}; x <= 60; ++x)
+        for (auto y{1}; y <= 60; ++y)
+        {
+            CHECK(table.gcd(x, y) == std::gcd(x, y));
+            CHECK(table.lcm(x, y) == std::lcm(x, y));
+            CHECK(table.gcd_divisor(x, y).value() == std::gcd(x, y));
+        }
+    // Above the dense limit, gcds are computed.
+    PeriodTable const large(65535);
+    for (auto [x, y] : {std::pair{65535, 3855}, {65534, 32767}, {2049, 2048}, {1, 65535}})
+    {
+        CHECK(large.gcd(x, y) == std::gcd(x, y));
+        CHECK(large.gcd_divisor(x, y).value() == std::gcd(x, y));
+    }
+    for (auto d : {1, 2, 3, 7, 60, 64, 1000, Divisor::limit - 1})
+    {
+        Divisor const divisor(d);
+        for (auto v : {0, 1, 2, 59, 60, 61, 1 << 20, Divisor::limit - 1, -1, -2, -60, -61,
+                       1 - Divisor::limit})
+        {
+            auto const residue{(v % d + d) % d};
+            CHECK(divisor.residue(v) == residue);
+            CHECK(divisor.divides(v) == (residue == 0));
+        }
+    }
+}
+
+TEST_CASE("kernels")
+{
+    std::array<std::uint16_t, 7> const lower{0, 2, 3, 7, 8, 12, 13};
+    std::array<std::uint16_t, 7> const upper{0, 1, 5, 6, 9, 11, 14};
+    CHECK(!gap_check(0, 1));
+    CHECK(!gap_check(1, max_kernel_gaps + 1));
+    for (std::size_t n_lower{1}; n_lower <= max_kernel_gaps; ++n_lower)
+        for (std::size_t n_upper{1}; n_upper <= max_kernel_gaps; ++n_upper)
+        {
+            auto const check{gap_check(n_lower, n_upper)};
+            REQUIRE(check);
+            for (auto d : {1, 2, 3, 5, 7, 15, 16})
+                for (auto shift{-d}; shift <= d; ++shift)
+                    CHECK(check(lower.data(), upper.data(), shift, Divisor(d))
+                          == disjoint_gaps(lower.data(), n_lower, upper.data(), n_upper,
+                                           shift, Divisor(d)));
+        }
+}
+
+TEST_CASE("batch")
+{
+    // Mixed offsets and numbers of bricks, including empty rows and more gaps than fit in
+    // a vector register.
+    std::vector<Row> rows{Row(0, {}), Row(3, {}), Row(0, std::vector<int>(12, 1)),
+                          Row(1, std::vector<int>(20, 2))};
+    for (auto offset : {0, 1, 4})
+        for (auto n_bricks : {1, 2, 3, 9})
+            for (auto const& row : make_rows(offset, n_bricks, 4))
+                if (rows.size() % 5 == 0 || n_bricks < 9)
+                    rows.push_back(row);
+    rows.push_back(Row(2, {255, 1, 255}));
+    // Check each kernel the processor supports, not just the one that would be chosen.
+    for (auto kernel : {BatchKernel::scalar, BatchKernel::sse4_1, BatchKernel::avx2})
+    {
+        if (!force_batch_kernel(kernel))
+            continue;
+        CAPTURE(static_cast<int>(kernel));
+        for (std::size_t i{0}; i < rows.size(); i += 11)
+        {
+            auto const fits{is_brickwork_many(rows[i], rows)};
+            CHECK(fits.size() == (rows.size() + 63)/64);
+            for (std::size_t j{0}; j < rows.size(); ++j)
+                CHECK(((fits[j/64] >> (j % 64)) & 1) == is_brickwork(rows[i], rows[j]));
+        }
+        // The bits past the end are cleared.
+        std::vector<std::uint64_t> out(2, ~std::uint64_t{0});
+        is_brickwork_many(Row(0, {1, 1}), std::span(rows).first(3), out);
+        CHECK(out[0] == 0);
+        CHECK(out[1] == ~std::uint64_t{0});
+    }
+    CHECK(force_batch_kernel(BatchKernel::best));
+}
+
+TEST_CASE("compatibility matrix")
+{
+    // Enough columns for more than one cache line per row and more than one tile.
+    auto const rows{make_rows(0, 3, 9)};
+    auto const columns{make_rows(1, 2, 30)};
+    CompatMatrix const compat(rows, columns, 3);
+    CHECK(compat.rows() == rows.size());
+    CHECK(compat.columns() == columns.size());
+    CHECK(compat.words()*CompatMatrix::word_bits >= columns.size());
+    for (std::size_t i{0}; i < rows.size(); i += 7)
+    {
+        CHECK(reinterpret_cast<std::uintptr_t>(compat.row(i).data()) % cache_line == 0);
+        std::vector<std::size_t> fits;
+        for (std::size_t j{0}; j < columns.size(); ++j)
+        {
+            CHECK(compat(i, j) == is_brickwork(rows[i], columns[j]));
+            if (compat(i, j))
+                fits.push_back(j);
+        }
+        std::vector<std::size_t> visited;
+        compat.for_each(i, [&visited](std::size_t j) { visited.push_back(j); });
+        CHECK(visited == fits);
+        CHECK(compat.count(i) == fits.size());
+
+        auto const k{(i*31 + 5) % rows.size()};
+        std::vector<CompatMatrix::Word> mask(compat.words(), 0);
+        std::size_t common{0};
+        std::size_t masked{0};
+        for (std::size_t j{0}; j < columns.size(); ++j)
+        {
+            if (j % 3 == 0)
+                mask[j/CompatMatrix::word_bits] |= CompatMatrix::Word{1}
+                    << (j % CompatMatrix::word_bits);
+            if (compat(i, j) && compat(k, j))
+            {
+                ++common;
+                if (j % 3 == 0)
+                    ++masked;
+            }
+        }
+        CHECK(compat.count_common(i, k) == common);
+        CHECK(compat.count_common(i, k, mask) == masked);
+    }
+
+    // The catalog's lists come from its matrix.
+    Catalog const catalog(3, 4);
+    for (std::size_t i{0}; i < catalog.size(); ++i)
+        CHECK(catalog.neighbors(0, i).size() == catalog.compatibility().count(i));
+}
+
+TEST_CASE("threads")
+{
+    auto const serial{generate(4, 2, 4)};
+    for (auto n_threads : {2, 3, 16})
+        CHECK(generate(4, 2, 4, n_threads) == serial);
+}
+
+TEST_CASE("visitor")
+{
+    auto const walls{generate(4, 2, 4)};
+    for (auto n_threads : {1, 3})
+    {
+        std::vector<Wall> visited;
+        generate(4, 2, 4, [&visited](Wall const& wall) { visited.push_back(wall); },
+                 n_threads);
+        CHECK(visited == walls);
+    }
+}
+
+TEST_CASE("svg")
+{
+    // Offsets, patterns that don't end at the edge, and more courses than rows.
+    auto walls{generate(4, 2, 3)};
+    walls.push_back({Row{0, {7}}, Row{1, {2, 8, 3}}});
+    for (auto n_courses : {1, 6})
+    {
+        auto const dir{std::filesystem::temp_directory_path()};
+        svg_walls((dir / "brickwork_stream_test.svg").string(), 300, walls, n_courses);
+        document_walls((dir / "brickwork_document_test.svg").string(), 300, walls,
+                       n_courses);
+        auto const stream{take_file(dir / "brickwork_stream_test.svg")};
+        auto const document{take_file(dir / "brickwork_document_test.svg")};
+        CHECK(!stream.empty());
+        CHECK(stream == document);
+    }
+}
+
+TEST_CASE("symbols")
+{
+    auto const walls{generate(4, 2, 3)};
+    auto const n_courses{6};
+    auto const file{std::filesystem::temp_directory_path() / "brickwork_symbols_test.svg"};
+    svg_walls(file.string(), 300, walls, n_courses, true);
+    auto const svg{take_file(file)};
+
+    CHECK(svg.find("xmlns:xlink=\"http://www.w3.org/1999/xlink\"") != std::string::npos);
+    // Each distinct row is defined once.
+    std::set<Row> distinct;
+    for (auto const& wall : walls)
+        distinct.insert(wall.begin(), wall.end());
+    std::map<std::string, int> defined;
+    std::regex const symbol{"<symbol id=\"(r[0-9]+)\""};
+    for (std::sregex_iterator it{svg.begin(), svg.end(), symbol}, end; it != end; ++it)
+        ++defined[(*it)[1]];
+    CHECK(defined.size() == distinct.size());
+    for (auto const& [id, n] : defined)
+        CHECK(n == 1);
+    // Each course of each wall refers to a defined row.
+    std::regex const use{"<use xlink:href=\"#(r[0-9]+)\""};
+    std::size_t n_uses{0};
+    for (std::sregex_iterator it{svg.begin(), svg.end(), use}, end; it != end; ++it, ++n_uses)
+        CHECK(defined.contains((*it)[1]));
+    CHECK(n_uses == walls.size()*n_courses);
+}
+
+TEST_CASE("arena")
+{
+    std::pmr::monotonic_buffer_resource arena;
+    auto const walls{generate(4, 2, 4, &arena)};
+    auto const expected{generate(4, 2, 4)};
+    CHECK(std::equal(walls.begin(), walls.end(), expected.begin(), expected.end()));
+    CHECK(walls.get_allocator().resource() == &arena);
+    for (auto const& wall : walls)
+        CHECK(wall.get_allocator().resource() == &arena);
+    auto const threaded{generate(4, 2, 4, &arena, 3)};
+    CHECK(threaded == walls);
+    for (auto const& wall : threaded)
+        CHECK(wall.get_allocator().resource() == &arena);
+
+    // Long patterns are copied into the arena. Any other allocation would throw.
+    std::vector<int> lengths(40, 1);
+    Row const row{0, lengths};
+    std::array<std::byte, 8192> buffer;
+    std::pmr::monotonic_buffer_resource fixed{buffer.data(), buffer.size(),
+                                              std::pmr::null_memory_resource()};
+    auto const old_default{std::pmr::set_default_resource(std::pmr::null_memory_resource())};
+    Wall wall{&fixed};
+    CHECK_NOTHROW(wall.push_back(row));
+    CHECK_NOTHROW(wall.emplace_back(1, lengths.begin(), lengths.end()));
+    // Moving within the arena takes over the pattern and leaves the source empty.
+    Row source{2, lengths.begin(), lengths.end(), &fixed};
+    Row const moved{std::move(source), &fixed};
+    std::pmr::set_default_resource(old_default);
+    CHECK(wall[0] == row);
+    CHECK(wall[1] == Row{1, lengths});
+    CHECK(moved == Row{2, lengths});
+    CHECK(source.pattern().empty());
+}
+
 TEST_CASE("generate")
 {
     std::vector<Wall> walls;
@@ -136,12 +708,123 @@ TEST_CASE("generate")
     {
         walls = generate(4, 2, 4);
         CHECK(walls.size() == 345);
+        CHECK(num_brickworks(4, 2, 4) == 345);
     }
 
     for (auto const& w : walls)
         CHECK_BW(w);
 }
 
+TEST_CASE("count courses")
+{
+    for (auto n_rows : {1, 3, 4, 5, 6, 8})
+        for (auto n_bricks : {1, 2, 3})
+            for (auto widest : {1, 2, 3, 4})
+                if (std::pow(widest, n_bricks) <= 30)
+                    CHECK(num_brickworks(n_rows, n_bricks, widest)
+                          == static_cast<std::int64_t>(
+                              generate(n_rows, n_bricks, widest).size()));
+}
+
+TEST_CASE("necklaces")
+{
+    // The number of necklaces of n beads of k colors is (1/n) sum phi(d) k^(n/d) over
+    // the divisors d of n.
+    CHECK(necklaces(4, 2).size() == 6);
+    CHECK(necklaces(6, 2).size() == 14);
+    CHECK(necklaces(3, 3).size() == 11);
+    auto const ns{necklaces(3, 2)};
+    REQUIRE(ns.size() == 4);
+    CHECK(ns[0].row.pattern() == Row(0, {1}).pattern());
+    CHECK(ns[1].row.pattern() == Row(0, {1, 1, 2}).pattern());
+    CHECK(ns[2].row.pattern() == Row(0, {1, 2, 2}).pattern());
+    CHECK(ns[3].row.pattern() == Row(0, {2}).pattern());
+
+    for (auto n_bricks : {1, 2, 3, 4, 6})
+        for (auto widest : {1, 2, 3, 4})
+        {
+            auto sum{0};
+            for (auto const& n : necklaces(n_bricks, widest))
+                sum += n.multiplicity;
+            CHECK(sum == std::pow(widest, n_bricks));
+        }
+
+    // The necklace count and num_brickworks() use different methods.
+    for (auto n_bricks : {1, 2, 3, 4})
+        for (auto widest : {1, 2, 3, 4, 5, 6, 9, 12})
+        {
+            auto const count{count_necklace_pairs(n_bricks, widest)};
+            CHECK(count.raw == num_brickworks(2, n_bricks, widest));
+            CHECK(count.canonical <= count.raw);
+        }
+    // Many bricks give residue sets with too many subsets for inclusion-exclusion.
+    for (auto [n_bricks, widest] : {std::pair{8, 2}, {12, 2}, {6, 3}, {8, 3}})
+    {
+        auto const count{count_necklace_pairs(n_bricks, widest)};
+        CHECK(count.raw == num_brickworks(2, n_bricks, widest));
+        CHECK(count.raw == num_brickworks(2, n_bricks, widest, 3));
+    }
+}
+
+// Shift the courses of the wall down by one and mirror them.
+Wall shift_and_mirror(Wall const& wall)
+{
+    Wall out;
+    for (std::size_t i{0}; i < wall.size(); ++i)
+    {
+        auto const& pattern{wall[(i + 1) % wall.size()].pattern()};
+        std::vector<int> mirror(pattern.begin(), pattern.end());
+        std::reverse(mirror.begin(), mirror.end());
+        out.emplace_back(i % 2, mirror);
+    }
+    return out;
+}
+
+TEST_CASE("symmetry")
+{
+    for (auto n_rows : {2, 4, 6})
+        for (auto n_bricks : {1, 2, 3})
+            for (auto widest : {2, 3, 4})
+                if (std::pow(widest, n_bricks) <= 30)
+                {
+                    auto const walls{generate(n_rows, n_bricks, widest)};
+                    std::set<Wall> const all(walls.begin(), walls.end());
+                    // The symmetry takes walls to walls.
+                    for (auto const& wall : walls)
+                        CHECK(all.contains(shift_and_mirror(wall)));
+
+                    // The orbits of the representatives cover all of the walls once.
+                    std::set<Wall> covered;
+                    std::int64_t n_orbits{0};
+                    std::size_t total{0};
+                    generate_canonical(n_rows, n_bricks, widest, [&](Orbit const& orbit) {
+                        ++n_orbits;
+                        total += orbit.size;
+                        std::set<Wall> images{orbit.wall};
+                        for (auto image{shift_and_mirror(orbit.wall)}; image != orbit.wall;
+                             image = shift_and_mirror(image))
+                        {
+                            CHECK(orbit.wall < image);
+                            images.insert(image);
+                        }
+                        CHECK(static_cast<int>(images.size()) == orbit.size);
+                        covered.insert(images.begin(), images.end());
+                    });
+                    CHECK(covered == all);
+                    CHECK(total == walls.size());
+
+                    auto const count{num_canonical_brickworks(n_rows, n_bricks, widest)};
+                    CHECK(count.canonical == n_orbits);
+                    CHECK(count.raw == static_cast<std::int64_t>(walls.size()));
+
+                    std::vector<Orbit> threaded;
+                    generate_canonical(n_rows, n_bricks, widest,
+                                       [&](Orbit const& orbit) { threaded.push_back(orbit); },
+                                       3);
+                    CHECK(static_cast<std::int64_t>(threaded.size()) == n_orbits);
+                }
+}
+
 TEST_CASE("count")
 {
     std::array const n_22i = { 0, 0, 1, 8, 33, 68, 193, 296, 615, 928, 1543 };
@@ -154,3 +837,56 @@ TEST_CASE("count")
         CHECK(static_cast<int>(num_brickworks(2, 3, i) == n_23i[i]));
     }
 }
+
+TEST_CASE("sweep")
+{
+    for (auto n_rows : {1, 2, 4})
+        for (auto n_bricks : {2, 3})
+        {
+            auto const counts{sweep_num_brickworks(n_rows, n_bricks, 8)};
+            CHECK(counts.size() == 9);
+            for (auto widest{0}; widest <= 8; ++widest)
+                CHECK(counts[widest] == num_brickworks(n_rows, n_bricks, widest));
+            CHECK(sweep_num_brickworks(n_rows, n_bricks, 8, 3) == counts);
+        }
+}
+
+TEST_CASE("grid")
+{
+    auto const counts{grid_num_brickworks({1, 6}, {1, 3}, {1, 6}, 2)};
+    CHECK(counts.size() == 6*3*6);
+    CHECK(std::is_sorted(counts.begin(), counts.end()));
+    for (auto const& c : counts)
+        CHECK(c.count == num_brickworks(c.n_rows, c.n_bricks, c.widest_brick));
+    // Start the powers of the matrices past the first course count.
+    for (auto const& c : grid_num_brickworks({7, 12}, {3, 3}, {3, 4}, 2))
+        CHECK(c.count == num_brickworks(c.n_rows, c.n_bricks, c.widest_brick));
+}
+
+TEST_CASE("count past the graph limit")
+{
+    // 16384 rows is too many for the transfer matrix. Counting them would take 2 GB.
+    CHECK(uses_backtracking(14, 2));
+    CHECK(!uses_backtracking(13, 2));
+    CHECK(uses_backtracking(2, 255));
+    // The walls are counted by backtracking instead.
+    for (auto n_rows : {4, 6})
+        for (auto n_bricks : {2, 3})
+            CHECK(backtrack_sweep_num_brickworks(n_rows, n_bricks, 5)
+                  == sweep_num_brickworks(n_rows, n_bricks, 5));
+}
+
+TEST_CASE("count with threads")
+{
+    for (auto n_rows : {2, 4})
+        for (auto widest : {3, 5, 8})
+        {
+            auto const count{num_brickworks(n_rows, 3, widest)};
+            for (auto n_threads : {2, 3, 7})
+                CHECK(num_brickworks(n_rows, 3, widest, n_threads) == count);
+        }
+    // Enough residues that the subsets of the classes are split between threads.
+    auto const count{num_brickworks(2, 5, 6)};
+    for (auto n_threads : {2, 16})
+        CHECK(num_brickworks(2, 5, 6, n_threads) == count);
+}
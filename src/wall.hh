@@ -16,40 +16,141 @@
 #ifndef ROW_HH
 #define ROW_HH
 
+#include "small_vector.hh"
+
+#include <cassert>
+#include <compare>
+#include <cstdint>
+#include <functional>
 #include <iosfwd>
+#include <iterator>
+#include <limits>
+#include <memory_resource>
 #include <string>
+#include <utility>
 #include <vector>
 
+/// Brick lengths from 0 to max_brick_width.
+using Pattern = SmallVector<std::uint8_t, 16>;
+/// The widest brick a pattern can hold.
+int constexpr max_brick_width{std::numeric_limits<Pattern::value_type>::max()};
+/// The longest period of a row. Gcds of periods are tabulated in 16 bits.
+int constexpr max_row_period{std::numeric_limits<std::uint16_t>::max()};
+/// Positions of the gaps between bricks within one period of a pattern. Less than the
+/// period, so they fit in 16 bits.
+using Perpends = SmallVector<std::uint16_t, 16>;
+
 /// A row of a brick wall described by an offset an a repeated pattern of lengths.
 class Row
 {
 public:
-    /// Construct a row from a one-time offset and a vector of lengths to repeat.
-    Row(int offset, std::vector<int> const& lengths)
-        : m_offset {offset}, m_pattern{lengths} {}
+    /// Rows that are elements of containers with a std::pmr allocator use it too.
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    /// Construct a row from a one-time offset and a vector of lengths to repeat. Lengths
+    /// must be at most max_brick_width and their sum at most max_row_period. Patterns
+    /// too long to store inline use memory from the allocator.
+    Row(int offset, std::vector<int> const& lengths, allocator_type alloc = {})
+        : Row(offset, lengths.begin(), lengths.end(), alloc) {}
+    /// Construct a row from a one-time offset and a range of lengths to repeat.
+    template <std::input_iterator It>
+    Row(int offset, It first, It last, allocator_type alloc = {});
+    Row(Row const&) = default;
+    /// Move a row. The source is left with no bricks and a period of 0.
+    Row(Row&& row) noexcept
+        : m_offset{row.m_offset},
+          m_period{std::exchange(row.m_period, 0)},
+          m_pattern(std::move(row.m_pattern)),
+          m_perpends(std::move(row.m_perpends))
+    {}
+    /// Copy a row using memory from the allocator.
+    Row(Row const& row, allocator_type alloc)
+        : m_offset{row.m_offset},
+          m_period{row.m_period},
+          m_pattern(row.m_pattern, alloc),
+          m_perpends(row.m_perpends, alloc)
+    {}
+    /// Move a row using memory from the allocator. Long patterns are taken over if they're
+    /// from an equal allocator. This is used when std::pmr containers of rows grow.
+    Row(Row&& row, allocator_type alloc)
+        : m_offset{row.m_offset},
+          m_period{std::exchange(row.m_period, 0)},
+          m_pattern(std::move(row.m_pattern), alloc),
+          m_perpends(std::move(row.m_perpends), alloc)
+    {}
+    Row& operator=(Row const&) = default;
+    Row& operator=(Row&& row)
+    {
+        m_offset = row.m_offset;
+        m_period = std::exchange(row.m_period, 0);
+        m_pattern = std::move(row.m_pattern);
+        m_perpends = std::move(row.m_perpends);
+        return *this;
+    }
     /// @return The offset.
     int offset() const { return m_offset; }
-    /// @return A vector of the repeated lengths.
-    std::vector<int> const& pattern() const {return m_pattern; }
+    /// @return The repeated lengths.
+    Pattern const& pattern() const {return m_pattern; }
     /// The total length of the repeated pattern.
-    int period() const;
+    int period() const { return m_period; }
+    /// @return The positions of the left ends of the bricks in the pattern relative to
+    /// the start of the pattern. The first is always 0.
+    Perpends const& perpends() const { return m_perpends; }
 
     /// @return A text representation of the row. A brick is shown as a number of
     /// spaces equal to its length separated by |. The total length is 80 characters.
     operator std::string() const;
-    /// Compare two rows.
-    auto operator <=>(Row const& row) const = default;
+    /// Compare two rows by offset and then pattern. The period and perpends follow from
+    /// the pattern.
+    std::strong_ordering operator <=>(Row const& row) const
+    {
+        if (auto const order{m_offset <=> row.m_offset}; order != 0)
+            return order;
+        return m_pattern <=> row.m_pattern;
+    }
+    bool operator ==(Row const& row) const
+    {
+        return m_offset == row.m_offset && m_pattern == row.m_pattern;
+    }
 
 private:
     /// An initial brick of length m_offset.
     int m_offset;
+    /// The sum of the pattern. Next to the offset so they share a word.
+    int m_period{0};
     /// The repeated bricks.
-    std::vector<int> m_pattern;
+    Pattern m_pattern;
+    /// The partial sums of the pattern.
+    Perpends m_perpends;
 };
 
+template <std::input_iterator It>
+Row::Row(int offset, It first, It last, allocator_type alloc)
+    : m_offset{offset},
+      m_pattern(alloc),
+      m_perpends(alloc)
+{
+    // Compute the period and partial sums once since they're used in the inner loops.
+    for (; first != last; ++first)
+    {
+        auto const length{static_cast<int>(*first)};
+        assert(length >= 0 && length <= max_brick_width && "Brick length out of range.");
+        m_pattern.push_back(static_cast<Pattern::value_type>(length));
+        m_perpends.push_back(static_cast<Perpends::value_type>(m_period));
+        m_period += length;
+    }
+    assert(m_period <= max_row_period && "Period out of range.");
+}
+
 /// Send the string representation to the stream.
 std::ostream& operator <<(std::ostream& os, Row const& row);
 
-using Wall = std::vector<Row>;
+/// The courses of a wall from bottom to top. A std::pmr vector so walls and their rows
+/// can be allocated together from one memory resource.
+using Wall = std::pmr::vector<Row>;
+/// A function that's called with each wall as it's found.
+using WallVisitor = std::function<void(Wall const&)>;
+/// A function that calls the visitor with each of a sequence of walls.
+using WallSource = std::function<void(WallVisitor const&)>;
 
 #endif // ROW_HH
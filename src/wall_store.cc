@@ -0,0 +1,160 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#include "wall_store.hh"
+#include "hash.hh"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <numeric>
+
+namespace
+{
+auto constexpr word_bits{64};
+}
+
+WallStore::WallStore(int n_rows, int n_bricks, int widest_brick)
+    : m_n_rows{n_rows},
+      m_n_bricks{n_bricks},
+      m_bits{std::max(1, static_cast<int>(std::bit_width(unsigned(widest_brick - 1))))},
+      // Walls with no bricks still need a word so they can be counted.
+      m_words{static_cast<std::size_t>(
+              std::max(1, (n_rows*n_bricks*m_bits + word_bits - 1)/word_bits))}
+{
+    assert(widest_brick >= 1 && widest_brick <= max_brick_width);
+}
+
+void WallStore::push_back(Wall const& wall)
+{
+    assert(static_cast<int>(wall.size()) == m_n_rows);
+    auto const first{m_keys.size()};
+    m_keys.resize(first + m_words, 0);
+    auto* key{m_keys.data() + first};
+    auto bit{0};
+    for (auto course{0}; course < m_n_rows; ++course)
+    {
+        auto const& row{wall[course]};
+        assert(row.offset() == course % 2);
+        assert(static_cast<int>(row.pattern().size()) == m_n_bricks);
+        for (auto width : row.pattern())
+        {
+            assert(width >= 1 && width - 1 < (1 << m_bits));
+            // The bits may be split across two words.
+            Word const value{static_cast<Word>(width - 1)};
+            auto const word{bit/word_bits};
+            auto const end{bit % word_bits + m_bits};
+            if (end <= word_bits)
+                key[word] |= value << (word_bits - end);
+            else
+            {
+                key[word] |= value >> (end - word_bits);
+                key[word + 1] |= value << (2*word_bits - end);
+            }
+            bit += m_bits;
+        }
+    }
+}
+
+int WallStore::width(std::size_t index, int course, int brick) const
+{
+    auto const* key{m_keys.data() + index*m_words};
+    auto const bit{(course*m_n_bricks + brick)*m_bits};
+    auto const word{bit/word_bits};
+    auto const end{bit % word_bits + m_bits};
+    auto const mask{(Word{1} << m_bits) - 1};
+    Word value;
+    if (end <= word_bits)
+        value = key[word] >> (word_bits - end);
+    else
+        value = (key[word] << (end - word_bits)) | (key[word + 1] >> (2*word_bits - end));
+    return static_cast<int>(value & mask) + 1;
+}
+
+Row WallStore::row(std::size_t index, int course) const
+{
+    Pattern pattern;
+    for (auto brick{0}; brick < m_n_bricks; ++brick)
+        pattern.push_back(width(index, course, brick));
+    return Row(course % 2, pattern.begin(), pattern.end());
+}
+
+Wall WallStore::operator[](std::size_t index) const
+{
+    Wall wall;
+    wall.reserve(m_n_rows);
+    for (auto course{0}; course < m_n_rows; ++course)
+        wall.push_back(row(index, course));
+    return wall;
+}
+
+std::size_t WallStore::hash(std::size_t index) const
+{
+    Fnv1a hash;
+    for (auto word : key(index))
+        hash.add(word);
+    return hash.value();
+}
+
+void WallStore::visit(WallVisitor const& visit) const
+{
+    // Decode each wall into the same vector so that its memory is reused.
+    Wall wall;
+    wall.reserve(m_n_rows);
+    for (std::size_t i{0}; i < size(); ++i)
+    {
+        wall.clear();
+        for (auto course{0}; course < m_n_rows; ++course)
+            wall.push_back(row(i, course));
+        visit(wall);
+    }
+}
+
+void WallStore::sort()
+{
+    if (m_words == 1)
+    {
+        std::sort(m_keys.begin(), m_keys.end());
+        return;
+    }
+    // Sort indices, then move the keys into place.
+    std::vector<std::size_t> order(size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](auto i, auto j) {
+        auto const a{key(i)};
+        auto const b{key(j)};
+        return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+    });
+    std::vector<Word> sorted;
+    sorted.reserve(m_keys.size());
+    for (auto i : order)
+        sorted.insert(sorted.end(), key(i).begin(), key(i).end());
+    m_keys = std::move(sorted);
+}
+
+void WallStore::dedupe()
+{
+    sort();
+    // Keep each key that differs from the last one kept.
+    std::size_t kept{0};
+    for (std::size_t i{0}; i < size(); ++i)
+        if (kept == 0 || !std::ranges::equal(key(i), key(kept - 1)))
+        {
+            if (i != kept)
+                std::ranges::copy(key(i), m_keys.begin() + kept*m_words);
+            ++kept;
+        }
+    m_keys.resize(kept*m_words);
+}
@@ -0,0 +1,81 @@
+// Copyright © 2021 Sam Varner
+//
+// This file is part of Brickwork.
+//
+// Composure is free software: you can redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// Composure is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+// PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with Composure.
+// If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef WALL_STORE_HH
+#define WALL_STORE_HH
+
+#include "wall.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// A compact container of walls with the shape that generate() produces: n_rows courses
+/// of n_bricks bricks from 1 to widest_brick units wide, with offsets alternating 0 and 1
+/// from the first course. Each wall is stored as a key of a fixed number of 64-bit words
+/// holding just enough bits for each brick width, and all of the keys are in one buffer.
+/// Walls and rows are decoded on demand. Comparing keys orders walls the same way as
+/// comparing them as vectors of rows.
+class WallStore
+{
+public:
+    using Word = std::uint64_t;
+
+    WallStore(int n_rows, int n_bricks, int widest_brick);
+
+    /// Encode a wall and add it to the end. The wall must have the store's shape.
+    void push_back(Wall const& wall);
+    /// @return The number of walls.
+    std::size_t size() const { return m_keys.size()/m_words; }
+    bool empty() const { return m_keys.empty(); }
+    /// @return The number of bytes used for keys.
+    std::size_t bytes() const { return m_keys.size()*sizeof(Word); }
+
+    /// @return The wall at the index.
+    Wall operator[](std::size_t index) const;
+    /// @return One course of the wall at the index.
+    Row row(std::size_t index, int course) const;
+    /// @return The key of the wall at the index.
+    std::span<Word const> key(std::size_t index) const
+    {
+        return {m_keys.data() + index*m_words, m_words};
+    }
+    /// @return A hash of the wall at the index. Equal walls have equal hashes.
+    std::size_t hash(std::size_t index) const;
+    /// Call the visitor with each wall in order.
+    void visit(WallVisitor const& visit) const;
+
+    /// Put the walls in order.
+    void sort();
+    /// Put the walls in order and remove duplicates.
+    void dedupe();
+
+private:
+    /// @return The stored width of a brick.
+    int width(std::size_t index, int course, int brick) const;
+
+    int m_n_rows;
+    int m_n_bricks;
+    /// The number of bits per brick.
+    int m_bits;
+    /// The number of words per wall.
+    std::size_t m_words;
+    /// The keys of all of the walls, m_words words each. Widths minus 1 are packed from
+    /// the most significant bit of the first word.
+    std::vector<Word> m_keys;
+};
+
+#endif // WALL_STORE_HH